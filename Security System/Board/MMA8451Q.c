@@ -10,12 +10,73 @@
 #include "MCUType.h"
 #include "MMA8451Q.h"
 /****************************************************************************************
+* Private defines and variables. The transaction at i2cHead is on the bus; it stays at
+* the head until its stop has been seen so the next start keeps the bus free time.
+* Reads of I2C_DMA_MIN_LEN or more bytes have all but the last two moved from I2C0_D by
+* DMA channel I2C_DMA_CH, one request per byte, with the I2C interrupt off. Its major
+* loop interrupt hands the last two bytes back to I2C0_IRQHandler, which has to set
+* TXAK and stop at the right bytes.
+****************************************************************************************/
+#define I2C_BUS_FREE_LOOPS 60       /* About 1.3us after the stop is detected            */
+#define I2C_DMA_CH 4
+#define I2C_DMAMUX_I2C0 22
+#define I2C_DMA_MIN_LEN 3
+
+/****************************************************************************************
+* FIFO batches. No MCU pin is used, so the driver does not depend on where the tower
+* routes INT1. Each task call with no FIFO transaction in flight queues a one byte read
+* of F_STATUS, and its done callback queues the batch read once F_WMRK_FLAG or F_OVF is
+* set. The flag stays set while F_CNT is at or over the watermark, so a FIFO that refilled
+* during a read is caught by the next poll. A batch is read into the buffer not last
+* completed.
+****************************************************************************************/
+#define MMA8451_F_MODE_CIRC 0x40u       /* F_SETUP F_MODE 01, circular                    */
+#define MMA8451_F_CNT_MASK 0x3fu        /* F_STATUS sample count                          */
+#define MMA8451_F_OVF 0x80u             /* F_STATUS FIFO overflowed                       */
+#define MMA8451_F_WMRK_FLAG 0x40u       /* F_STATUS F_CNT at or over the watermark        */
+#define MMA8451_ACTIVE 0x01u
+#if (MMA8451_FIFO_HZ == 800)
+#define MMA8451_DR 0u
+#elif (MMA8451_FIFO_HZ == 400)
+#define MMA8451_DR 1u
+#elif (MMA8451_FIFO_HZ == 200)
+#define MMA8451_DR 2u
+#elif (MMA8451_FIFO_HZ == 100)
+#define MMA8451_DR 3u
+#elif (MMA8451_FIFO_HZ == 50)
+#define MMA8451_DR 4u
+#else
+#error "MMA8451_FIFO_HZ must be 50, 100, 200, 400 or 800"
+#endif
+#if ((MMA8451_FIFO_WMRK < 1) || (MMA8451_FIFO_WMRK > 32))
+#error "MMA8451_FIFO_WMRK must be 1 to 32"
+#endif
+
+static I2C_XFER mma8451FifoXfer;
+static I2C_XFER mma8451PollXfer;
+static INT8U mma8451PollStatus;         /* F_STATUS from the last poll                    */
+static MMA8451_BATCH mma8451Batch[2];
+static INT8U mma8451FifoFill = 0;       /* Buffer being read into                         */
+static const MMA8451_BATCH *mma8451FifoLast = 0;
+static INT32U mma8451FifoSeq = 0;
+
+typedef enum{I2C_PH_ADDR, I2C_PH_REG, I2C_PH_TX, I2C_PH_RADDR, I2C_PH_RX, I2C_PH_STOP} I2C_PHASE;
+
+static I2C_XFER *i2cHead = 0;
+static I2C_XFER *i2cTail = 0;
+static I2C_PHASE i2cPhase;
+static INT8U i2cIndex;
+static I2C_XFER_STATUS i2cResult;
+/****************************************************************************************
 * Function prototypes (Private)
 ****************************************************************************************/
-static void I2CWr(INT8U dout);
-static INT8U I2CRd(void);
-static void I2CStop(void);
-static void I2CStart(void);
+static void I2CStart(I2C_XFER *xfer);
+static void I2CStop(I2C_XFER_STATUS result);
+static void I2CWait(I2C_XFER *xfer);
+static void I2CDMAStart(I2C_XFER *xfer);
+static void MMA8451FIFOPolled(I2C_XFER *xfer);
+static void MMA8451FIFODone(I2C_XFER *xfer);
+static void MMA8451Unpack(INT8U status, const INT8U *data, MMA8451_XYZ *xyz);
 static void BusFreeDly(void);
 /****************************************************************************************
 * I2CInit - Initialize I2C for the MMA8451Q
@@ -28,8 +89,159 @@ void I2CInit(void){
     PORTE_PCR18 = PORT_PCR_MUX(4)|PORT_PCR_ODE(1);  /* and open drain                  */
 
     I2C0_F  = 0x2c;                                 /* Set SCL to 104kHz               */
-    I2C0_C1 |= I2C_C1_IICEN(1);                     /* Enable I2C                      */
-}                                                
+    I2C0_C1 |= I2C_C1_IICEN(1)|I2C_C1_IICIE(1);     /* Enable I2C and its interrupt    */
+    NVIC_ClearPendingIRQ(I2C0_IRQn);
+    NVIC_EnableIRQ(I2C0_IRQn);
+
+    SIM_SCGC6 |= SIM_SCGC6_DMAMUX_MASK;             /* Receive DMA, I2C0_D to memory   */
+    SIM_SCGC7 |= SIM_SCGC7_DMA_MASK;
+    DMAMUX_CHCFG(I2C_DMA_CH) = DMAMUX_CHCFG_ENBL(0);
+    DMA_SADDR(I2C_DMA_CH) = DMA_SADDR_SADDR(&I2C0_D);
+    DMA_ATTR(I2C_DMA_CH) = (DMA_ATTR_SSIZE(0) | DMA_ATTR_SMOD(0) | DMA_ATTR_DMOD(0) | DMA_ATTR_DSIZE(0));
+    DMA_SOFF(I2C_DMA_CH) = 0;
+    DMA_SLAST(I2C_DMA_CH) = DMA_SLAST_SLAST(0);
+    DMA_DOFF(I2C_DMA_CH) = DMA_DOFF_DOFF(1);
+    DMA_NBYTES_MLNO(I2C_DMA_CH) = DMA_NBYTES_MLNO_NBYTES(1);
+    DMA_DLAST_SGA(I2C_DMA_CH) = DMA_DLAST_SGA_DLASTSGA(0);
+    DMA_CSR(I2C_DMA_CH) = (DMA_CSR_INTMAJOR(1)|DMA_CSR_DREQ(1));
+    DMAMUX_CHCFG(I2C_DMA_CH) = DMAMUX_CHCFG_ENBL(1)|DMAMUX_CHCFG_SOURCE(I2C_DMAMUX_I2C0);
+    NVIC_ClearPendingIRQ(DMA4_DMA20_IRQn);
+    NVIC_EnableIRQ(DMA4_DMA20_IRQn);
+}
+
+/****************************************************************************************
+* I2CQueue - Queue a transaction, started at once if the queue is empty
+****************************************************************************************/
+void I2CQueue(I2C_XFER *xfer){
+    xfer->next = 0;
+    xfer->status = I2C_XFER_QUEUED;
+    NVIC_DisableIRQ(I2C0_IRQn);
+    if(i2cHead == 0){
+        i2cHead = xfer;
+        i2cTail = xfer;
+        I2CStart(xfer);
+    } else{
+        i2cTail->next = xfer;
+        i2cTail = xfer;
+    }
+    NVIC_EnableIRQ(I2C0_IRQn);
+}
+/****************************************************************************************
+* I2CBusy - Returns 1 while any transaction is queued or on the bus
+****************************************************************************************/
+INT8U I2CBusy(void){
+    return (INT8U)(i2cHead != 0);
+}
+/****************************************************************************************
+* I2C0_IRQHandler - One interrupt per byte, plus one for the stop. RXAK is checked after
+*                   every byte sent. A read sends the device address again after a
+*                   repeated start, then receives with no ack on the last byte and stops
+*                   before reading it so no extra byte is clocked in.
+****************************************************************************************/
+void I2C0_IRQHandler(void){
+    I2C_XFER *xfer = i2cHead;
+
+    if(xfer == 0){
+        I2C0_FLT = (INT8U)((I2C0_FLT & ~I2C_FLT_SSIE_MASK)|I2C_FLT_STOPF_MASK|I2C_FLT_STARTF_MASK);
+        I2C0_S |= I2C_S_IICIF(1);   /* Nothing queued, stray flag                      */
+    } else if((I2C0_FLT & I2C_FLT_STOPF_MASK) != 0){
+        I2C0_FLT = (INT8U)((I2C0_FLT & ~I2C_FLT_SSIE_MASK)|I2C_FLT_STOPF_MASK|I2C_FLT_STARTF_MASK);
+        I2C0_S |= I2C_S_IICIF(1);
+        i2cHead = xfer->next;
+        if(i2cHead == 0){
+            i2cTail = 0;
+        } else{
+        }
+        BusFreeDly();
+        xfer->status = i2cResult;
+        if(xfer->done != 0){
+            xfer->done(xfer);       /* May queue, and so start, another                */
+        } else{
+        }
+        if((i2cHead != 0) && (i2cHead->status == I2C_XFER_QUEUED)){
+            I2CStart(i2cHead);
+        } else{
+        }
+    } else{
+        I2C0_S |= I2C_S_IICIF(1);
+        if((i2cPhase != I2C_PH_RX) && (i2cPhase != I2C_PH_STOP) && ((I2C0_S & I2C_S_RXAK_MASK) != 0)){
+            I2CStop(I2C_XFER_NAK);
+        } else{
+            switch(i2cPhase){
+                case(I2C_PH_ADDR):
+                    I2C0_D = xfer->reg;
+                    i2cPhase = I2C_PH_REG;
+                    break;
+                case(I2C_PH_REG):
+                    if(xfer->dir == I2C_XFER_RD){
+                        I2C0_C1 |= I2C_C1_RSTA_MASK;
+                        I2C0_D = (INT8U)((xfer->addr<<1)|RD);
+                        i2cPhase = I2C_PH_RADDR;
+                    } else if(xfer->len != 0){
+                        I2C0_D = xfer->data[0];
+                        i2cIndex = 1;
+                        i2cPhase = I2C_PH_TX;
+                    } else{
+                        I2CStop(I2C_XFER_DONE);
+                    }
+                    break;
+                case(I2C_PH_TX):
+                    if(i2cIndex < xfer->len){
+                        I2C0_D = xfer->data[i2cIndex];
+                        i2cIndex++;
+                    } else{
+                        I2CStop(I2C_XFER_DONE);
+                    }
+                    break;
+                case(I2C_PH_RADDR):
+                    I2C0_C1 &= (INT8U)(~I2C_C1_TX_MASK);   /* Master receive              */
+                    if(xfer->len == 1){
+                        I2C0_C1 |= I2C_C1_TXAK_MASK;        /* No ack on the only byte     */
+                    } else{
+                        I2C0_C1 &= (INT8U)(~I2C_C1_TXAK_MASK);
+                    }
+                    i2cIndex = 0;
+                    i2cPhase = I2C_PH_RX;
+                    if(xfer->len >= I2C_DMA_MIN_LEN){
+                        I2CDMAStart(xfer);
+                    } else{
+                    }
+                    (void)I2C0_D;                           /* Dummy read clocks byte 0    */
+                    break;
+                case(I2C_PH_RX):
+                    if(i2cIndex == (INT8U)(xfer->len - 1)){
+                        I2CStop(I2C_XFER_DONE);
+                    } else if(i2cIndex == (INT8U)(xfer->len - 2)){
+                        I2C0_C1 |= I2C_C1_TXAK_MASK;        /* No ack on the next, last    */
+                    } else{
+                    }
+                    xfer->data[i2cIndex] = I2C0_D;          /* Clocks the next, if any     */
+                    i2cIndex++;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+/****************************************************************************************
+* DMA4_DMA20_IRQHandler - Receive DMA done, all but the last two bytes are in. The byte
+*                         after them is already being clocked, so the I2C interrupt is
+*                         given back with a stale IICIF cleared, and pended by hand if
+*                         that byte has finished meanwhile.
+*                         Handler must be public for linker to see it.
+****************************************************************************************/
+void DMA4_DMA20_IRQHandler(void){
+    DMA_CINT = DMA_CINT_CINT(I2C_DMA_CH);
+    I2C0_C1 &= (INT8U)(~I2C_C1_DMAEN_MASK);
+    I2C0_S |= I2C_S_IICIF(1);
+    I2C0_C1 |= I2C_C1_IICIE_MASK;
+    if((I2C0_S & I2C_S_TCF_MASK) != 0){
+        NVIC_SetPendingIRQ(I2C0_IRQn);
+    } else{
+    }
+}
 
 /****************************************************************************************
 * MMA8451RegWr - Write to MMA8451 register. Blocks until Xmit is complete.
@@ -38,11 +250,16 @@ void I2CInit(void){
 *   wdata is the value to be written to waddr
 ****************************************************************************************/
 void MMA8451RegWr(INT8U waddr, INT8U wdata){
-    I2CStart();                     /* Create I2C start                                */
-    I2CWr((MMA8451_ADDR<<1)|WR);    /* Send MMA8451 address & W/R' bit                 */
-    I2CWr(waddr);                   /* Send register address                           */
-    I2CWr(wdata);                   /* Send write data                                 */
-    I2CStop();                      /* Create I2C stop                                 */
+    I2C_XFER xfer;
+
+    xfer.addr = MMA8451_ADDR;
+    xfer.reg = waddr;               /* Register address                                */
+    xfer.dir = I2C_XFER_WR;
+    xfer.len = 1;
+    xfer.data = &wdata;             /* Write data                                      */
+    xfer.done = 0;
+    I2CQueue(&xfer);
+    I2CWait(&xfer);
 }
 /****************************************************************************************
 * MMA8451RegRd - Read from MMA8451 register. Blocks until read is complete
@@ -51,16 +268,89 @@ void MMA8451RegWr(INT8U waddr, INT8U wdata){
 *   return value is the value read
 ****************************************************************************************/
 INT8U MMA8451RegRd(INT8U raddr){
-    INT8U rdata;
-    I2CStart();                     /* Create I2C start                                */
-    I2CWr((MMA8451_ADDR<<1)|WR);    /* Send MMA8451 address & W/R' bit                 */
-    I2CWr(raddr);                   /* Send register address                           */
-    I2C0_C1 |= I2C_C1_RSTA_MASK;    /* Repeated Start                                  */
-    I2CWr((MMA8451_ADDR<<1)|RD);    /* Send MMA8451 address & W/R' bit                 */
-    rdata = I2CRd();                /* Send to read MMA8451 return value               */
+    I2C_XFER xfer;
+    INT8U rdata = 0;
+
+    MMA8451RegRdQueue(&xfer, raddr, &rdata, 0);
+    I2CWait(&xfer);
     return rdata;
 }
 /****************************************************************************************
+* MMA8451RegRdQueue - Queue a read of one MMA8451 register. Does not block.
+* Parameters:
+*   xfer is the caller's transaction, not in use
+*   raddr is the register address to read
+*   rdata is where the value is put
+*   done is called when complete, or 0
+****************************************************************************************/
+void MMA8451RegRdQueue(I2C_XFER *xfer, INT8U raddr, INT8U *rdata, void (*done)(I2C_XFER *xfer)){
+    xfer->addr = MMA8451_ADDR;
+    xfer->reg = raddr;
+    xfer->dir = I2C_XFER_RD;
+    xfer->len = 1;
+    xfer->data = rdata;
+    xfer->done = done;
+    I2CQueue(xfer);
+}
+/****************************************************************************************
+* MMA8451FIFOInit - Run the 8451 at MMA8451_FIFO_HZ with the FIFO in watermark mode.
+*                   F_SETUP can only be written in standby. The FIFO interrupt is left
+*                   off, MMA8451FIFOTask() polls F_STATUS.
+****************************************************************************************/
+void MMA8451FIFOInit(void){
+    INT8U treg;
+    treg = MMA8451RegRd(MMA8451_CTRL_REG1);
+    treg = treg & 0xfeu;            /* Clear active bit to put in standby mode         */
+    MMA8451RegWr(MMA8451_CTRL_REG1,treg);
+    MMA8451RegWr(MMA8451_F_SETUP,MMA8451_F_MODE_CIRC|MMA8451_FIFO_WMRK);
+    treg = (INT8U)((treg & ~0x3eu)|(MMA8451_DR<<3));    /* ODR, 14 bit reads           */
+    MMA8451RegWr(MMA8451_CTRL_REG1,treg|MMA8451_ACTIVE);
+}
+/****************************************************************************************
+* MMA8451FIFOTask - Poll F_STATUS when neither the poll nor a batch read is in flight.
+*                   At 104kHz the poll is about 0.4ms of bus per slice.
+****************************************************************************************/
+void MMA8451FIFOTask(void){
+    if((mma8451PollXfer.status != I2C_XFER_QUEUED) && (mma8451PollXfer.status != I2C_XFER_BUSY) &&
+       (mma8451FifoXfer.status != I2C_XFER_QUEUED) && (mma8451FifoXfer.status != I2C_XFER_BUSY)){
+        MMA8451RegRdQueue(&mma8451PollXfer, MMA8451_STATUS, &mma8451PollStatus, MMA8451FIFOPolled);
+    } else{
+    }
+}
+/****************************************************************************************
+* MMA8451FIFOGet - Return the latest complete batch, or 0 before the first
+****************************************************************************************/
+const MMA8451_BATCH *MMA8451FIFOGet(INT32U *seq){
+    const MMA8451_BATCH *batch;
+    NVIC_DisableIRQ(I2C0_IRQn);
+    batch = mma8451FifoLast;
+    *seq = mma8451FifoSeq;
+    NVIC_EnableIRQ(I2C0_IRQn);
+    return batch;
+}
+/****************************************************************************************
+* MMA8451BatchCount - Valid samples in a batch, F_CNT when read, at most the watermark.
+*                     F_CNT is 32 after an overflow.
+****************************************************************************************/
+INT8U MMA8451BatchCount(const MMA8451_BATCH *batch){
+    INT8U count = (INT8U)(batch->f_status & MMA8451_F_CNT_MASK);
+    if((batch->f_status & MMA8451_F_OVF) != 0){
+        count = 32;                 /* F_OVF, FIFO full                                */
+    } else{
+    }
+    if(count > MMA8451_FIFO_WMRK){
+        count = MMA8451_FIFO_WMRK;
+    } else{
+    }
+    return count;
+}
+/****************************************************************************************
+* MMA8451BatchXYZ - Convert one sample of a batch to signed 14 bit counts
+****************************************************************************************/
+void MMA8451BatchXYZ(const MMA8451_BATCH *batch, INT8U i, MMA8451_XYZ *xyz){
+    MMA8451Unpack(batch->f_status, batch->xyz[i], xyz);
+}
+/****************************************************************************************
 * MMA8451PLInit - Initialize 8451 for portrait/landscape detection.
 * Parameters:
 ****************************************************************************************/
@@ -74,55 +364,92 @@ void MMA8451PLInit(void){
     MMA8451RegWr(MMA8451_CTRL_REG1,treg);
 }
 /****************************************************************************************
-* I2CWr - Write one byte to I2C. Blocks until byte Xmit is complete
-* Parameters:
-*   dout is the data/address to send
+* I2CStart - Generate a Start sequence to grab the I2C bus and send the device address.
 ****************************************************************************************/
-static void I2CWr(INT8U dout){
-    I2C0_D = dout;                              /* Send data/address                   */
-    while((I2C0_S & I2C_S_IICIF_MASK) == 0) {}  /* Wait for completion                 */
-    I2C0_S |= I2C_S_IICIF(1);                 /* Clear IICIF flag                    */
+static void I2CStart(I2C_XFER *xfer){
+    xfer->status = I2C_XFER_BUSY;
+    i2cPhase = I2C_PH_ADDR;
+    I2C0_C1 |= I2C_C1_TX_MASK;
+    I2C0_C1 |= I2C_C1_MST_MASK;
+    I2C0_D = (INT8U)((xfer->addr<<1)|WR);   /* Send device address & W/R' bit          */
 }
-
 /****************************************************************************************
-* I2CRd - Read one byte from I2C. Blocks until byte reception is complete
-* Parameters:
-*   Return value is the data returned from the MMA8451
+* I2CStop - Generate a Stop sequence to free the I2C bus. The stop detect interrupt
+*           then ends the transaction.
 ****************************************************************************************/
-static INT8U I2CRd(void){
-    INT8U din;
-    I2C0_C1 &= (INT8U)(~I2C_C1_TX_MASK);               /*Set to master receive mode           */
-    I2C0_C1 |= I2C_C1_TXAK_MASK;                /*Set to no ack on read                */
-    din = I2C0_D;                               /*Dummy read to generate clock cycles  */
-    while((I2C0_S & I2C_S_IICIF_MASK) == 0) {}  /* Wait for completion                 */
-    I2C0_S |= I2C_S_IICIF(1);                 /* Clear IICIF flag                    */
-    I2CStop();                                  /* Send Stop                           */
-    din = I2C0_D;                               /* Read data that was clocked in       */
-    return din;
+static void I2CStop(I2C_XFER_STATUS result){
+    i2cResult = result;
+    i2cPhase = I2C_PH_STOP;
+    I2C0_FLT = (INT8U)(I2C0_FLT|I2C_FLT_SSIE_MASK|I2C_FLT_STOPF_MASK|I2C_FLT_STARTF_MASK);
+    I2C0_C1 &= (INT8U)(~I2C_C1_MST_MASK);
+    I2C0_C1 &= (INT8U)(~I2C_C1_TX_MASK);
 }
 /****************************************************************************************
-* I2CStop - Generate a Stop sequence to free the I2C bus.
+* MMA8451FIFOPolled - F_STATUS poll complete, from I2C0_IRQHandler. At the watermark,
+*                     F_STATUS and MMA8451_FIFO_WMRK samples are queued as one
+*                     transaction starting at STATUS, since in FIFO mode the address
+*                     wraps from OUT_Z_LSB to OUT_X_MSB.
 ****************************************************************************************/
-static void I2CStop(void){
-    I2C0_C1 &= (INT8U)(~I2C_C1_MST_MASK);
-    I2C0_C1 &= (INT8U)(~I2C_C1_TX_MASK);
-    BusFreeDly();
+static void MMA8451FIFOPolled(I2C_XFER *xfer){
+    if((xfer->status == I2C_XFER_DONE) &&
+       ((mma8451PollStatus & (MMA8451_F_WMRK_FLAG|MMA8451_F_OVF)) != 0)){
+        mma8451FifoXfer.addr = MMA8451_ADDR;
+        mma8451FifoXfer.reg = MMA8451_STATUS;
+        mma8451FifoXfer.dir = I2C_XFER_RD;
+        mma8451FifoXfer.len = (INT8U)sizeof(MMA8451_BATCH);
+        mma8451FifoXfer.data = &mma8451Batch[mma8451FifoFill].f_status;
+        mma8451FifoXfer.done = MMA8451FIFODone;
+        I2CQueue(&mma8451FifoXfer);
+    } else{
+    }
 }
 /****************************************************************************************
-* I2CStart - Generate a Start sequence to grab the I2C bus.
+* MMA8451FIFODone - Batch read complete, from I2C0_IRQHandler. A NAKed read is dropped,
+*                   the next poll retries it.
 ****************************************************************************************/
-static void I2CStart(void){
-    I2C0_C1 |= I2C_C1_TX_MASK;
-    I2C0_C1 |= I2C_C1_MST_MASK;
+static void MMA8451FIFODone(I2C_XFER *xfer){
+    if(xfer->status == I2C_XFER_DONE){
+        mma8451FifoLast = &mma8451Batch[mma8451FifoFill];
+        mma8451FifoSeq++;
+        mma8451FifoFill ^= 1u;
+    } else{
+    }
+}
+/****************************************************************************************
+* MMA8451Unpack - X, Y, Z MSB/LSB to signed 14 bit counts, left justified in 16 bits
+****************************************************************************************/
+static void MMA8451Unpack(INT8U status, const INT8U *data, MMA8451_XYZ *xyz){
+    xyz->status = status;
+    xyz->x = (INT16S)((INT16U)((data[0]<<8)|data[1])) >> 2;
+    xyz->y = (INT16S)((INT16U)((data[2]<<8)|data[3])) >> 2;
+    xyz->z = (INT16S)((INT16U)((data[4]<<8)|data[5])) >> 2;
+}
+/****************************************************************************************
+* I2CDMAStart - Hand bytes 0 to len-3 of a read to DMA, with the I2C interrupt off.
+****************************************************************************************/
+static void I2CDMAStart(I2C_XFER *xfer){
+    DMA_DADDR(I2C_DMA_CH) = DMA_DADDR_DADDR(xfer->data);
+    DMA_CITER_ELINKNO(I2C_DMA_CH) = DMA_CITER_ELINKNO_CITER(xfer->len - 2);
+    DMA_BITER_ELINKNO(I2C_DMA_CH) = DMA_BITER_ELINKNO_BITER(xfer->len - 2);
+    DMA_SERQ = DMA_SERQ_SERQ(I2C_DMA_CH);
+    i2cIndex = (INT8U)(xfer->len - 2);
+    I2C0_C1 &= (INT8U)(~I2C_C1_IICIE_MASK);
+    I2C0_C1 |= I2C_C1_DMAEN_MASK;
+}
+/****************************************************************************************
+* I2CWait - Block until a transaction is complete, for init before the scheduler runs.
+****************************************************************************************/
+static void I2CWait(I2C_XFER *xfer){
+    while((xfer->status == I2C_XFER_QUEUED) || (xfer->status == I2C_XFER_BUSY)){
+        /* wait */
+    }
 }
 /****************************************************************************************
 * BusFreeDly - Generate a short delay for the minimum bus free time, 1.3us
 ****************************************************************************************/
 static void BusFreeDly(void){
-    for(INT8U i = 0; i < 250; i++ ){
+    for(volatile INT8U i = 0; i < I2C_BUS_FREE_LOOPS; i++ ){
         /* wait */
     }
 }
 /***************************************************************************************/
-
-  
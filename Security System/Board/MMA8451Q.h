@@ -7,6 +7,49 @@
  ***********************************************************************/
 #ifndef ACCEL_DEF
 #define ACCEL_DEF
+/************************************************************************
+* I2C transactions. One is a start, the device address, a register address
+* then either len bytes written, or a repeated start and len bytes read,
+* and a stop. The caller owns the I2C_XFER and must not touch it while
+* status is I2C_XFER_QUEUED or I2C_XFER_BUSY.
+*************************************************************************/
+typedef enum{I2C_XFER_WR, I2C_XFER_RD} I2C_XFER_DIR;
+typedef enum{I2C_XFER_IDLE, I2C_XFER_QUEUED, I2C_XFER_BUSY, I2C_XFER_DONE, I2C_XFER_NAK} I2C_XFER_STATUS;
+
+typedef struct I2C_XFER_S{
+    INT8U addr;                     /* 7 bit device address                    */
+    INT8U reg;                      /* Register address sent first             */
+    I2C_XFER_DIR dir;
+    INT8U len;                      /* Bytes to write or read, a read needs 1+ */
+    INT8U *data;
+    void (*done)(struct I2C_XFER_S *xfer);  /* Called from the ISR, or 0      */
+    volatile I2C_XFER_STATUS status;
+    struct I2C_XFER_S *next;        /* Queue link, set by I2CQueue()           */
+} I2C_XFER;
+
+/************************************************************************
+* One sample converted from a FIFO batch.
+*************************************************************************/
+typedef struct{
+    INT8U status;
+    INT16S x;                       /* 14 bit, 4096 counts per g at +/-2g      */
+    INT16S y;
+    INT16S z;
+} MMA8451_XYZ;
+
+/************************************************************************
+* FIFO batches. The FIFO runs circular at MMA8451_FIFO_HZ and F_STATUS is
+* polled until MMA8451_FIFO_WMRK samples are in, which are then read in
+* one burst: F_STATUS then X, Y, Z MSB/LSB per sample, oldest first.
+*************************************************************************/
+#define MMA8451_FIFO_HZ 200         /* Output data rate, see CTRL_REG1 DR       */
+#define MMA8451_FIFO_WMRK 20        /* Samples per batch, 100ms, max 32         */
+
+typedef struct{
+    INT8U f_status;                 /* F_OVF, F_WMRK_FLAG and F_CNT before read */
+    INT8U xyz[MMA8451_FIFO_WMRK][6];
+} MMA8451_BATCH;
+
 /************************************************************************
 * Public Functions
 *************************************************************************
@@ -14,8 +57,84 @@
 *************************************************************************/
 void I2CInit(void);
 
+/*************************************************************************
+* I2CQueue - Queue a transaction. Returns at once, I2C0_IRQHandler runs the
+*            queue in order, reads of 3 or more bytes mostly by DMA, and sets status to I2C_XFER_DONE, or
+*            I2C_XFER_NAK if the device did not acknowledge, then calls done.
+*            done may queue another transaction.
+* Parameters:
+*   xfer is the transaction, all fields but status and next filled in
+*************************************************************************/
+void I2CQueue(I2C_XFER *xfer);
+
+/*************************************************************************
+* I2CBusy - Returns 1 while any transaction is queued or on the bus
+*************************************************************************/
+INT8U I2CBusy(void);
+
+/*************************************************************************
+* I2C0_IRQHandler - Runs the transaction queue, one byte per interrupt.
+*                   Handler must be public for linker to see it.
+*************************************************************************/
+void I2C0_IRQHandler(void);
+
+/*************************************************************************
+* DMA4_DMA20_IRQHandler - Ends the DMA part of an I2C0 burst read.
+*                         Handler must be public for linker to see it.
+*************************************************************************/
+void DMA4_DMA20_IRQHandler(void);
+
+/*************************************************************************
+* MMA8451RegRdQueue - Queue a read of one MMA8451 register. Does not block.
+* Parameters:
+*   xfer is the caller's transaction, not in use
+*   raddr is the register address to read
+*   rdata is where the value is put
+*   done is called when complete, or 0
+*************************************************************************/
+void MMA8451RegRdQueue(I2C_XFER *xfer, INT8U raddr, INT8U *rdata, void (*done)(I2C_XFER *xfer));
+
+/*************************************************************************
+* MMA8451FIFOInit - Run the 8451 at MMA8451_FIFO_HZ with the FIFO in
+*                   watermark mode. Call after MMA8451PLInit().
+*************************************************************************/
+void MMA8451FIFOInit(void);
+
+/*************************************************************************
+* MMA8451FIFOTask - Poll F_STATUS, a batch read is queued when the
+*                   watermark is reached. Does not block, call every slice.
+*************************************************************************/
+void MMA8451FIFOTask(void);
+
+/*************************************************************************
+* MMA8451FIFOGet - Return the latest complete batch, or 0 before the first.
+*                  It stays valid for a whole batch period.
+* Parameters:
+*   seq is where the batch count is put, to see a new batch
+*************************************************************************/
+const MMA8451_BATCH *MMA8451FIFOGet(INT32U *seq);
+
+/*************************************************************************
+* MMA8451BatchCount - Return the valid samples in a batch, F_CNT when it
+*                     was read but at most MMA8451_FIFO_WMRK. The rest are
+*                     empty FIFO reads.
+* Parameters:
+*   batch is the batch read
+*************************************************************************/
+INT8U MMA8451BatchCount(const MMA8451_BATCH *batch);
+
+/*************************************************************************
+* MMA8451BatchXYZ - Convert one sample of a batch to signed 14 bit counts
+* Parameters:
+*   batch is the batch read
+*   i is the sample, 0 is the oldest
+*   xyz is where the sample is put, status is F_STATUS
+*************************************************************************/
+void MMA8451BatchXYZ(const MMA8451_BATCH *batch, INT8U i, MMA8451_XYZ *xyz);
+
 /*************************************************************************
 * MMA8451RegWr - Write to MMA8451 register. Blocks until Xmit is complete.
+*                For init only, the scheduler should use I2CQueue().
 * Parameters:
 *   waddr is the address of the MMA8451 register to write
 *   wdata is the value to be written to waddr
@@ -23,7 +142,8 @@ void I2CInit(void);
 void MMA8451RegWr(INT8U waddr, INT8U wdata);
 
 /*************************************************************************
-* MMA8451RegRd - Read from MMA8451 register. Blocks until read is complete
+* MMA8451RegRd - Read from MMA8451 register. Blocks until read is complete.
+*                For init only, see MMA8451RegRdQueue().
 * Parameters:
 *   raddr is the register address to read
 *   return value is the value read
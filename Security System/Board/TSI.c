@@ -1,7 +1,26 @@
 /*******************************************************************************
 * TSI.c - A module for initializing the touch sensors on board, polling the
 *            current state of the sensors, and sending the current state of the
-*            sensors.
+*            sensors. The electrodes are listed in tsiElectrodes[], each with
+*            its TSI channel and touch threshold limits, and all per
+*            electrode state is indexed by position in that table. Adding a
+*            pad is one more table entry.
+*            The touch decision itself, baselines, noise and levels, is in
+*            TSITouch.c, which touches no hardware.
+*            Scans are started in hardware by LPTMR0 every TSI_SCAN_PERIOD_MS.
+*            The threshold registers hold the touch window of the electrode
+*            being scanned so TSI0_IRQHandler only runs when that pad crosses
+*            its touch or release level. TSITask rotates the scanned pad
+*            round robin.
+*            The scan parameters (charge currents, prescaler, scan count) are
+*            picked once by tsiTune() as the fastest set that still meets
+*            TSI_TUNE_MIN_SNR, and kept in flash at FLASH_NV_ADDR.
+*            Each change of the touched bitmask is queued with a timestamp
+*            for TSIGetEvent(), see TSIGesture.c.
+*            TSIProxEnter() switches to a proximity mode on one electrode
+*            with a longer integration and a lower threshold so a hand is
+*            seen before it touches. The scans keep running in LLS, and the
+*            out-of-range interrupt is an LLWU wakeup source, see LowPower.c.
 *
 * Created on: Nov 29, 2017
 * Author: Anthony Needles
@@ -9,115 +28,612 @@
 #include "MCUType.h"
 #include "TSI.h"
 #include "K65TWR_GPIO.h"
+#include "TSIFilter.h"
+#include "TSITouch.h"
+#include "Flash.h"
+#include "SysTickDelay.h"
 
-#define E1_TOUCH_OFFSET 2000
-#define E2_TOUCH_OFFSET 2000
-#define E1 12
-#define E2 11
+#define TSI_CAL_SAMPLES 16      //Scans per electrode averaged at startup
+#define TSI_SCAN_PERIOD_MS 2    //LPTMR0 hardware trigger period
+#define TSI_NO_ELECTRODE 0xFFu
+#define TSI_GENCS_W1C_MASK (TSI_GENCS_OUTRGF_MASK|TSI_GENCS_EOSF_MASK)
+#define TSI_GENCS_SCAN_MASK (TSI_GENCS_REFCHRG_MASK|TSI_GENCS_EXTCHRG_MASK|TSI_GENCS_PS_MASK|TSI_GENCS_NSCN_MASK)
+#define TSI_GENCS_SCAN_DEFAULT (TSI_GENCS_REFCHRG(5)|TSI_GENCS_EXTCHRG(5)|TSI_GENCS_PS(5)|TSI_GENCS_NSCN(15))
+#define TSI_TUNE_SAMPLES 8      //Scans per electrode for each tried set
+#define TSI_TUNE_MIN_SNR 20     //Expected touch signal over mean noise
+#define TSI_TUNE_MAGIC 0x54534931u  //"TSI1"
+#define TSI_EVENT_QUEUE_LEN 8
+#define TSI_PROX_ELECTRODE 0    //tsiElectrodes[] index used for proximity
+#define TSI_PROX_PERIOD_MS 20   //Scan period, bounds the wakeup latency
+#define TSI_PROX_NSCN 31        //32 scans per result, the most TSI0 allows
+#define TSI_PROX_NOISE_MULT 4   //Proximity delta in multiples of noise
+#define TSI_PROX_MIN_FRAC 1     //Lower limit on proximity delta, baseline/256ths
 
-typedef enum{E2SCAN_E1READ, E1SCAN_E2READ} SENSORSTATE;
+typedef struct{
+    INT8U channel;              //TSI0 channel
+    TSI_TOUCH_LIMITS limits;    //See TSITouch.h
+} TSI_ELECTRODE;
 
-static INT16U tsiTouchLevelE1;
-static INT16U tsiTouchLevelE2;
-static SENSORSTATE tsiSensorState;
-static INT8U tsiSensorFlags[2];
+typedef struct{
+    INT32U magic;
+    INT32U gencs;               //TSI_GENCS_SCAN_MASK fields
+    INT32U cycles;              //Core clocks for the slowest electrode scan
+    INT32U check;               //~(magic^gencs^cycles)
+} TSI_TUNE_RECORD;
+
+static const TSI_ELECTRODE tsiElectrodes[TSI_NUM_ELECTRODES] = {
+    {12, {8, 4, 32}},           //E1
+    {11, {8, 4, 32}}            //E2
+};
+
+static const INT8U tsiTuneChrg[] = {3, 5, 7};
+static const INT8U tsiTunePs[] = {1, 3, 5};
+static const INT8U tsiTuneNscn[] = {3, 7, 15, 31};
+
+static volatile INT8U tsiActive;        //Electrode on the hardware trigger
+static volatile INT8U tsiPending;       //Electrode of a scan still in flight
+static INT32U tsiGencsScan;
+static TSI_EVENT tsiEventQueue[TSI_EVENT_QUEUE_LEN];
+static volatile INT8U tsiEventIn;
+static volatile INT8U tsiEventOut;
+static INT32U tsiGencsProx;
+static INT32U tsiProxRatioQ8;   //Proximity over touch baseline
+static INT32U tsiProxNoiseQ8;
+static INT16U tsiProxLevel;
+static volatile INT8U tsiProxMode;
+static volatile INT8U tsiProxNear;
+#if TSI_FILT_SIMD_EN
+static TSI_FILT_BENCH tsiFiltBench;    //For the debugger, see TSIFilter.c
+#endif
+
+static INT16U tsiScan(INT8U channel);
+static void tsiCalibrate(INT8U channel, INT32U *base_q8, INT32U *noise_q8);
+static void tsiTrack(INT8U index, INT16U count);
+static void tsiSetWindow(INT8U index);
+static void tsiSelect(INT8U index);
+static void tsiPostEvent(void);
+static void tsiTune(void);
+static void tsiTuneMeasure(INT32U gencs, INT32U max_cycles, INT32U *cycles, INT32U *snr);
 
 /********************************************************************
 * TSIInit - Initializes  and calibrates TSI
 *
-* Description:  Enables electrodes 0 and 1 for use within program. Calibrates
-*               the sensors based off of a control baseline and a small offset
-*               to ensure noise does not trigger the sensors yet light presses
-*               still get sensed.
+* Description:  Enables the electrodes in tsiElectrodes[]. Calibrates each
+*               sensor by averaging TSI_CAL_SAMPLES scans for the starting
+*               baseline and the mean deviation of those scans for the
+*               starting noise level. The touch levels are set from these,
+*               see TSITouchInit().
+*               The scan parameters come from the record in flash, or from
+*               tsiTune() if there is no valid record yet. The proximity
+*               parameters are the same with the prescaler one step slower
+*               and TSI_PROX_NSCN scans; the proximity electrode is also
+*               calibrated with them to get its noise and the ratio of its
+*               count to the touch count.
+*               The SIMD filter kernels are checked against the C ones and
+*               both are timed into tsiFiltBench, see TSIFiltCheck().
+*               Then sets up LPTMR0 from the 1kHz LPO as the periodic scan
+*               trigger, switches TSI0 to hardware triggered scans with the
+*               out-of-range interrupt and starts on the first electrode.
 *
 * Return value: None
 *
 * Arguments:    None
 ********************************************************************/
 void TSIInit(void){
-    INT16U baseline_e1;
-    INT16U baseline_e2;
+    const TSI_TUNE_RECORD *rec = (const TSI_TUNE_RECORD *)FLASH_NV_ADDR;
+    INT32U base_q8;
+    INT32U noise_q8;
+    INT32U prox_base_q8;
+    INT32U ps;
+    INT8U i;
 
     SIM_SCGC5 |= (SIM_SCGC5_PORTB_MASK|SIM_SCGC5_TSI_MASK);
     PORTA_PCR18 = PORT_PCR_MUX(0);
     PORTA_PCR19 = PORT_PCR_MUX(0);
-    TSI0_GENCS = (TSI_GENCS_MODE(0)|TSI_GENCS_REFCHRG(5)|TSI_GENCS_DVOLT(0)|TSI_GENCS_EXTCHRG(5)|TSI_GENCS_PS(5)|TSI_GENCS_NSCN(15));
+    if((rec->magic == TSI_TUNE_MAGIC) && (rec->check == ~(rec->magic^rec->gencs^rec->cycles))){
+        tsiGencsScan = (rec->gencs & TSI_GENCS_SCAN_MASK);
+    } else{
+        tsiTune();
+    }
+#if TSI_FILT_SIMD_EN
+    TSIFiltCheck(&tsiFiltBench);
+#endif
+    TSI0_GENCS = (TSI_GENCS_MODE(0)|TSI_GENCS_DVOLT(0)|tsiGencsScan);
     TSI0_GENCS |= TSI_GENCS_TSIEN(1);
 
-    TSI0_DATA = TSI_DATA_TSICH(E1); //Calibration for E1
-    TSI0_DATA |= TSI_DATA_SWTS(1);
-    while(!(TSI0_GENCS & TSI_GENCS_EOSF_MASK)){} //Wait for scan to finish
-    TSI0_GENCS |= TSI_GENCS_EOSF(1);
-    baseline_e1 = (INT16U)(TSI0_DATA & TSI_DATA_TSICNT_MASK);
-    tsiTouchLevelE1 = (baseline_e1 + E1_TOUCH_OFFSET);
+    for(i = 0; i < TSI_NUM_ELECTRODES; i++){
+        tsiCalibrate(tsiElectrodes[i].channel, &base_q8, &noise_q8);
+        TSITouchInit(i, &tsiElectrodes[i].limits, base_q8, noise_q8);
+    }
 
-    TSI0_DATA = TSI_DATA_TSICH(E2); //Calibration for E2
-    TSI0_DATA |= TSI_DATA_SWTS(1);
-    while(!(TSI0_GENCS & TSI_GENCS_EOSF_MASK)){} //Is not blocking
-    TSI0_GENCS |= TSI_GENCS_EOSF(1);
-    baseline_e2 = (INT16U)(TSI0_DATA & TSI_DATA_TSICNT_MASK);
-    tsiTouchLevelE2 = (baseline_e2 + E2_TOUCH_OFFSET);
+    ps = ((tsiGencsScan & TSI_GENCS_PS_MASK) >> TSI_GENCS_PS_SHIFT);
+    if(ps < 7){
+        ps++;
+    } else{
+    }
+    tsiGencsProx = ((tsiGencsScan & ~(TSI_GENCS_PS_MASK|TSI_GENCS_NSCN_MASK))|
+                    TSI_GENCS_PS(ps)|TSI_GENCS_NSCN(TSI_PROX_NSCN));
+    TSI0_GENCS = (TSI_GENCS_MODE(0)|TSI_GENCS_DVOLT(0)|tsiGencsProx);
+    TSI0_GENCS |= TSI_GENCS_TSIEN(1);
+    tsiCalibrate(tsiElectrodes[TSI_PROX_ELECTRODE].channel, &prox_base_q8, &tsiProxNoiseQ8);
+    tsiProxRatioQ8 = prox_base_q8 / (TSITouchBaseQ8(TSI_PROX_ELECTRODE) >> TSI_Q);
+    tsiProxMode = 0;
+    tsiProxNear = 0;
+    TSI0_GENCS = 0;
+    TSI0_GENCS = (TSI_GENCS_MODE(0)|TSI_GENCS_DVOLT(0)|tsiGencsScan);
+    TSI0_GENCS |= TSI_GENCS_TSIEN(1);
+
+    SIM_SCGC5 |= SIM_SCGC5_LPTMR_MASK;
+    LPTMR0_CSR = 0;
+    LPTMR0_PSR = (LPTMR_PSR_PCS(1)|LPTMR_PSR_PBYP(1)); //1kHz LPO, no prescale
+    LPTMR0_CMR = (TSI_SCAN_PERIOD_MS - 1);
+
+    TSI0_GENCS &= ~(TSI_GENCS_TSIEN_MASK|TSI_GENCS_W1C_MASK);
+    TSI0_GENCS |= (TSI_GENCS_STM(1)|TSI_GENCS_ESOR(0)|TSI_GENCS_TSIIEN(1));
+    tsiActive = 0;
+    tsiSelect(0);
+    tsiPending = TSI_NO_ELECTRODE;
+    TSI0_GENCS |= (TSI_GENCS_TSIEN(1)|TSI_GENCS_W1C_MASK);
+    NVIC_ClearPendingIRQ(TSI0_IRQn);
+    NVIC_EnableIRQ(TSI0_IRQn);
+    LPTMR0_CSR = LPTMR_CSR_TEN(1);
 }
 /********************************************************************
-* TSITask - Poll both TSI counters for values over calibrated TouchLevel
+* TSITask - Rotates the hardware scanned electrode
 *
-* Description:  Uses a state machine design that starts a scan for second electrode,
-*               while reading the current value for the first, then switches to
-*               reading the second electrode and starting scan for the first to
-*               ensure scanning is completed by the time the value is read.
+* Description:  Only one TSI channel is scanned by the hardware trigger at a
+*               time, so each slice the next electrode in the table is
+*               selected and its touch window is loaded into the threshold
+*               registers. The touch decisions themselves are made in
+*               TSI0_IRQHandler. The TSI interrupt is masked while the
+*               channel is switched. Nothing is switched in proximity mode.
 *
 * Return value: None
 *
 * Arguments:    None
 ********************************************************************/
 void TSITask(void){
-    static INT8U st_slice_counter = 1;
+    INT8U next;
 
     DB3_TURN_ON();
-    if(st_slice_counter > 0){
-        st_slice_counter = 0;
-        switch(tsiSensorState){
-            case(E2SCAN_E1READ):
-                TSI0_DATA = TSI_DATA_TSICH(E2); //Start E2 scan
-                TSI0_DATA |= TSI_DATA_SWTS(1);
-                if((INT16U)(TSI0_DATA & TSI_DATA_TSICNT_MASK) > tsiTouchLevelE1){
-                    tsiSensorFlags[E1FLAG] = 1; //Read E1
-                } else{
-                    tsiSensorFlags[E1FLAG] = 0;
-                }
-                tsiSensorState = E1SCAN_E2READ;
-                break;
-            case(E1SCAN_E2READ):
-                TSI0_DATA = TSI_DATA_TSICH(E1); //Start E1 scan
-                TSI0_DATA |= TSI_DATA_SWTS(1);
-                if((INT16U)(TSI0_DATA & TSI_DATA_TSICNT_MASK) > tsiTouchLevelE2){
-                    tsiSensorFlags[E2FLAG] = 1; //Read E2
-                } else{
-                    tsiSensorFlags[E2FLAG] = 0;
-                }
-                tsiSensorState = E2SCAN_E1READ;
-                break;
-            default:
-                break;
+    if(tsiProxMode == 0){
+        NVIC_DisableIRQ(TSI0_IRQn);
+        next = (INT8U)(tsiActive + 1);
+        if(next >= TSI_NUM_ELECTRODES){
+            next = 0;
+        } else{
         }
+        tsiSelect(next);
+        NVIC_EnableIRQ(TSI0_IRQn);
     } else{
-        st_slice_counter++;
     }
     DB3_TURN_OFF();
 }
 /********************************************************************
-* TSIGetSensor - Sends status of electrodes (activated/idle)
+* TSIGetSensors - Sends status of electrodes (activated/idle)
+*
+* Description:  Bit n is set while electrode n of tsiElectrodes[] is touched.
+*
+* Return value: Bitmask of touched electrodes
+*
+* Arguments:    None
+********************************************************************/
+INT32U TSIGetSensors(void){
+    return(TSITouchMask());
+}
+/********************************************************************
+* TSIGetEvent - Takes the oldest touch transition from the queue
+*
+* Description:  Every change of the touched bitmask is queued with its time
+*               by the TSI interrupt, so a consumer sees each press and
+*               release in order even if it runs later. The interrupt only
+*               moves tsiEventIn and this only moves tsiEventOut.
+*
+* Return value: 1 if an event was copied out, 0 if the queue was empty
+*
+* Arguments:    Pointer to the event to be filled
+********************************************************************/
+INT8U TSIGetEvent(TSI_EVENT *event){
+    INT8U got = 0;
+
+    if(tsiEventOut != tsiEventIn){
+        *event = tsiEventQueue[tsiEventOut];
+        tsiEventOut = (INT8U)((tsiEventOut + 1) % TSI_EVENT_QUEUE_LEN);
+        got = 1;
+    } else{
+    }
+    return(got);
+}
+/********************************************************************
+* TSIProxEnter - Switches TSI0 to proximity mode
+*
+* Description:  Only TSI_PROX_ELECTRODE is scanned, with the proximity
+*               parameters, every TSI_PROX_PERIOD_MS from LPTMR0. Its
+*               baseline is the touch baseline, which keeps following drift
+*               in touch mode, times the ratio measured at TSIInit(). The
+*               threshold is TSI_PROX_NOISE_MULT times the proximity noise,
+*               at least TSI_PROX_MIN_FRAC of the baseline, which is well
+*               under the touch threshold. STPE keeps the scans running in
+*               LLS, so with TSI0 as an LLWU source an approach wakes the
+*               part within one scan period.
+*               Touch decisions stop until TSIProxExit().
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void TSIProxEnter(void){
+    const TSI_ELECTRODE *elec = &tsiElectrodes[TSI_PROX_ELECTRODE];
+    INT32U base;
+    INT32U delta;
+    INT32U level;
+
+    NVIC_DisableIRQ(TSI0_IRQn);
+    LPTMR0_CSR = 0;
+    TSI0_GENCS &= ~(TSI_GENCS_TSIEN_MASK|TSI_GENCS_W1C_MASK);
+
+    base = (((TSITouchBaseQ8(TSI_PROX_ELECTRODE) >> TSI_Q)*tsiProxRatioQ8) >> TSI_Q);
+    delta = ((TSI_PROX_NOISE_MULT*tsiProxNoiseQ8) >> TSI_Q);
+    if(delta < ((base*TSI_PROX_MIN_FRAC) >> 8)){
+        delta = ((base*TSI_PROX_MIN_FRAC) >> 8);
+    } else{
+    }
+    level = base + delta;
+    if(level > 0xFFFEu){
+        level = 0xFFFEu;
+    } else{
+    }
+    tsiProxLevel = (INT16U)level;
+    tsiProxNear = 0;
+    tsiProxMode = 1;
+
+    TSI0_GENCS = ((TSI0_GENCS & ~(TSI_GENCS_SCAN_MASK|TSI_GENCS_ESOR_MASK|TSI_GENCS_W1C_MASK))|
+                  tsiGencsProx|TSI_GENCS_STPE(1));
+    TSI0_DATA = TSI_DATA_TSICH(elec->channel);
+    TSI0_TSHD = (TSI_TSHD_THRESH(tsiProxLevel)|TSI_TSHD_THRESL(0));
+    tsiPending = TSI_NO_ELECTRODE;
+    TSI0_GENCS |= (TSI_GENCS_TSIEN(1)|TSI_GENCS_W1C_MASK);
+    LPTMR0_CMR = (TSI_PROX_PERIOD_MS - 1);
+    NVIC_ClearPendingIRQ(TSI0_IRQn);
+    NVIC_EnableIRQ(TSI0_IRQn);
+    LPTMR0_CSR = LPTMR_CSR_TEN(1);
+}
+/********************************************************************
+* TSIProxExit - Returns TSI0 to touch mode
+*
+* Description:  Restores the touch scan parameters and period and
+*               reselects the electrode that was active before.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void TSIProxExit(void){
+    NVIC_DisableIRQ(TSI0_IRQn);
+    LPTMR0_CSR = 0;
+    TSI0_GENCS &= ~(TSI_GENCS_TSIEN_MASK|TSI_GENCS_W1C_MASK);
+    TSI0_GENCS = ((TSI0_GENCS & ~(TSI_GENCS_SCAN_MASK|TSI_GENCS_STPE_MASK|TSI_GENCS_W1C_MASK))|
+                  tsiGencsScan);
+    tsiProxMode = 0;
+    tsiSelect(tsiActive);
+    TSI0_GENCS |= (TSI_GENCS_TSIEN(1)|TSI_GENCS_W1C_MASK);
+    LPTMR0_CMR = (TSI_SCAN_PERIOD_MS - 1);
+    NVIC_ClearPendingIRQ(TSI0_IRQn);
+    NVIC_EnableIRQ(TSI0_IRQn);
+    LPTMR0_CSR = LPTMR_CSR_TEN(1);
+}
+/********************************************************************
+* TSIGetProximity - Returns whether an approach was seen then clears it
+*
+* Description:  Read-once handshake like GetKey(). Only set in proximity
+*               mode.
+*
+* Return value: 1 if the proximity level was crossed, else 0
+*
+* Arguments:    None
+********************************************************************/
+INT8U TSIGetProximity(void){
+    INT8U near = tsiProxNear;
+
+    tsiProxNear = 0;
+    return(near);
+}
+/********************************************************************
+* TSI0_IRQHandler - TSI0 end of scan and out-of-range interrupt
+*
+* Description:  After a channel switch the end of scan interrupt is used.
+*               If a scan was still in progress at the switch its result
+*               belongs to the previous electrode and is handed to tsiTrack()
+*               for that electrode, so the next channel's scan overlaps the
+*               read of the previous one and no scan is wasted. The first
+*               scan of the new channel is also tracked so the baseline keeps
+*               following drift. From then on only the out-of-range interrupt
+*               is used, which fires when the count leaves the window set by
+*               tsiSetWindow(), i.e. when the pad is touched or released. The
+*               window only moves once the filtered decision changes, so a
+*               real touch keeps raising this interrupt every scan until the
+*               filter has confirmed it.
+*               In proximity mode an out-of-range is an approach. It is
+*               flagged once and the window opened so it does not repeat
+*               every scan.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void TSI0_IRQHandler(void){
+    INT32U gencs;
+    INT16U count;
+
+    gencs = TSI0_GENCS;
+    TSI0_GENCS = gencs;                     //Clear EOSF/OUTRGF
+    count = (INT16U)(TSI0_DATA & TSI_DATA_TSICNT_MASK);
+    if(tsiProxMode != 0){
+        if(count > tsiProxLevel){
+            tsiProxNear = 1;
+            TSI0_TSHD = (TSI_TSHD_THRESH(0xFFFFu)|TSI_TSHD_THRESL(0));
+        } else{
+        }
+    } else if((gencs & TSI_GENCS_ESOR_MASK) != 0){
+        if(tsiPending != TSI_NO_ELECTRODE){
+            tsiTrack(tsiPending, count);
+            tsiPending = TSI_NO_ELECTRODE;
+        } else{
+            tsiTrack(tsiActive, count);
+            tsiSetWindow(tsiActive);
+            TSI0_GENCS = ((TSI0_GENCS & ~(TSI_GENCS_ESOR_MASK|TSI_GENCS_W1C_MASK))|TSI_GENCS_ESOR(0));
+        }
+    } else{
+        tsiTrack(tsiActive, count);
+        tsiSetWindow(tsiActive);
+    }
+}
+/********************************************************************
+* tsiScan - Runs one blocking software scan of a TSI channel
 *
-* Description:  With the electrode index as a parameter, returns state of
-*               corresponding sensor activation flag.
+* Description:  Only used at startup. Selects the channel, starts a software
+*               scan, then waits for the end of scan flag.
 *
-* Return value: Current state of requested electrode
+* Return value: TSICNT result of the scan
 *
-* Arguments:    Requested electrode to have it's state returned
+* Arguments:    TSI channel to be scanned
 ********************************************************************/
-INT8U TSIGetSensor(INT8U electrode){
-    return(tsiSensorFlags[electrode]);
+static INT16U tsiScan(INT8U channel){
+    TSI0_DATA = TSI_DATA_TSICH(channel);
+    TSI0_DATA |= TSI_DATA_SWTS(1);
+    while(!(TSI0_GENCS & TSI_GENCS_EOSF_MASK)){} //Wait for scan to finish
+    TSI0_GENCS |= TSI_GENCS_EOSF(1);
+    return((INT16U)(TSI0_DATA & TSI_DATA_TSICNT_MASK));
+}
+/********************************************************************
+* tsiCalibrate - Measures the baseline and noise of one channel
+*
+* Description:  Takes TSI_CAL_SAMPLES scans with the current scan parameters,
+*               see TSITouchStats().
+*
+* Return value: None
+*
+* Arguments:    TSI channel, and where to put the baseline and noise in Q8
+********************************************************************/
+static void tsiCalibrate(INT8U channel, INT32U *base_q8, INT32U *noise_q8){
+    INT16U samples[TSI_CAL_SAMPLES];
+    INT8U i;
+
+    for(i = 0; i < TSI_CAL_SAMPLES; i++){
+        samples[i] = tsiScan(channel);
+    }
+    TSITouchStats(samples, TSI_CAL_SAMPLES, base_q8, noise_q8);
+}
+/********************************************************************
+* tsiTrack - Hands one sample to the touch decision
+*
+* Description:  A change of the touched bitmask is queued, see TSITouchSample().
+*
+* Return value: None
+*
+* Arguments:    Electrode index in tsiElectrodes[] and its latest TSICNT
+********************************************************************/
+static void tsiTrack(INT8U index, INT16U count){
+    if(TSITouchSample(index, count) != 0){
+        tsiPostEvent();
+    } else{
+    }
+}
+/********************************************************************
+* tsiPostEvent - Queues the current bitmask with a timestamp
+*
+* Description:  If the queue is full the event is dropped, the bitmask
+*               itself is still current through TSIGetSensors().
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+static void tsiPostEvent(void){
+    INT8U next = (INT8U)((tsiEventIn + 1) % TSI_EVENT_QUEUE_LEN);
+
+    if(next != tsiEventOut){
+        tsiEventQueue[tsiEventIn].mask = TSITouchMask();
+        tsiEventQueue[tsiEventIn].time = SysTickGetmsCount();
+        tsiEventIn = next;
+    } else{
+    }
+}
+/********************************************************************
+* tsiSetWindow - Loads the threshold registers for one electrode
+*
+* Description:  An idle pad is out of range above its touch level, a touched
+*               pad is out of range under its release level.
+*
+* Return value: None
+*
+* Arguments:    Electrode index in tsiElectrodes[]
+********************************************************************/
+static void tsiSetWindow(INT8U index){
+    if((TSITouchMask() & (1uL << index)) == 0){
+        TSI0_TSHD = (TSI_TSHD_THRESH(TSITouchLevel(index))|TSI_TSHD_THRESL(0));
+    } else{
+        TSI0_TSHD = (TSI_TSHD_THRESH(0xFFFFu)|TSI_TSHD_THRESL(TSITouchReleaseLevel(index)));
+    }
+}
+/********************************************************************
+* tsiSelect - Switches the hardware scanned channel
+*
+* Description:  The channel is written first, then if a scan is still in
+*               progress it must belong to the previously active electrode,
+*               which is kept in tsiPending so its result is not lost. The
+*               end of scan interrupt is used until the first scan of the
+*               new channel has been read in TSI0_IRQHandler.
+*
+* Return value: None
+*
+* Arguments:    Electrode index in tsiElectrodes[]
+********************************************************************/
+static void tsiSelect(INT8U index){
+    INT8U previous = tsiActive;
+
+    tsiActive = index;
+    TSI0_DATA = TSI_DATA_TSICH(tsiElectrodes[index].channel);
+    tsiSetWindow(index);
+    if((TSI0_GENCS & TSI_GENCS_SCNIP_MASK) != 0){
+        tsiPending = previous;
+    } else{
+        tsiPending = TSI_NO_ELECTRODE;
+    }
+    TSI0_GENCS = ((TSI0_GENCS & ~TSI_GENCS_W1C_MASK)|TSI_GENCS_ESOR(1));
 }
+/********************************************************************
+* tsiTune - Picks the fastest scan parameters that meet TSI_TUNE_MIN_SNR
+*
+* Description:  Tries every combination of the REFCHRG, EXTCHRG, PS and NSCN
+*               values in the tsiTune tables on all electrodes. A set slower
+*               than the best one found so far is dropped after the first
+*               electrode. Of the sets whose worst electrode SNR meets the target
+*               the shortest scan time wins; if none do, the highest SNR
+*               wins. The result is written to the flash record so this only
+*               runs on the first start. Scan time is counted with the DWT
+*               cycle counter.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+static void tsiTune(void){
+    INT32U gencs;
+    INT32U cycles;
+    INT32U snr;
+    INT32U best_cycles = 0xFFFFFFFFu;
+    INT32U best_snr = 0;
+    INT32U best_gencs = TSI_GENCS_SCAN_DEFAULT;
+    INT32U fallback_gencs = TSI_GENCS_SCAN_DEFAULT;
+    INT32U rec[4];
+    INT8U rc, ec, ps, ns;
 
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    for(rc = 0; rc < sizeof(tsiTuneChrg); rc++){
+        for(ec = 0; ec < sizeof(tsiTuneChrg); ec++){
+            for(ps = 0; ps < sizeof(tsiTunePs); ps++){
+                for(ns = 0; ns < sizeof(tsiTuneNscn); ns++){
+                    gencs = (TSI_GENCS_REFCHRG(tsiTuneChrg[rc])|TSI_GENCS_EXTCHRG(tsiTuneChrg[ec])|
+                             TSI_GENCS_PS(tsiTunePs[ps])|TSI_GENCS_NSCN(tsiTuneNscn[ns]));
+                    tsiTuneMeasure(gencs, best_cycles, &cycles, &snr);
+                    if(snr >= TSI_TUNE_MIN_SNR){
+                        if(cycles < best_cycles){
+                            best_cycles = cycles;
+                            best_gencs = gencs;
+                        } else{
+                        }
+                    } else if(snr > best_snr){
+                        best_snr = snr;
+                        fallback_gencs = gencs;
+                    } else{
+                    }
+                }
+            }
+        }
+    }
+    if(best_cycles == 0xFFFFFFFFu){
+        best_gencs = fallback_gencs;
+    } else{
+    }
+    tsiGencsScan = best_gencs;
 
+    rec[0] = TSI_TUNE_MAGIC;
+    rec[1] = best_gencs;
+    rec[2] = best_cycles;
+    rec[3] = ~(rec[0]^rec[1]^rec[2]);
+    if(FlashEraseSector(FLASH_NV_ADDR) == 0){
+        (void)FlashProgramPhrase(FLASH_NV_ADDR, &rec[0]);
+        (void)FlashProgramPhrase(FLASH_NV_ADDR + 8u, &rec[2]);
+    } else{
+    }
+}
+/********************************************************************
+* tsiTuneMeasure - Scan time and SNR of one set of scan parameters
+*
+* Description:  Takes TSI_TUNE_SAMPLES software scans of every electrode.
+*               The signal is the expected touch, max_frac of the mean count,
+*               and the noise is the mean absolute deviation. The results
+*               are the slowest scan and the lowest SNR over all electrodes.
+*               Stops after the first electrode slower than max_cycles with
+*               an SNR of 0, since such a set can not win.
+*
+* Return value: None
+*
+* Arguments:    Scan parameter bits, time to beat, and the two results
+********************************************************************/
+static void tsiTuneMeasure(INT32U gencs, INT32U max_cycles, INT32U *cycles, INT32U *snr){
+    INT16U samples[TSI_TUNE_SAMPLES];
+    INT32U start;
+    INT32U scan_cycles;
+    INT32U sum;
+    INT32U dev_sum;
+    INT32U mean;
+    INT32U signal;
+    INT32U elec_snr;
+    INT8U index;
+    INT8U i;
 
+    TSI0_GENCS = 0;
+    TSI0_GENCS = (TSI_GENCS_MODE(0)|TSI_GENCS_DVOLT(0)|gencs);
+    TSI0_GENCS |= TSI_GENCS_TSIEN(1);
+    *cycles = 0;
+    *snr = 0xFFFFFFFFu;
+    for(index = 0; (index < TSI_NUM_ELECTRODES) && (*snr != 0); index++){
+        sum = 0;
+        for(i = 0; i < TSI_TUNE_SAMPLES; i++){
+            start = DWT->CYCCNT;
+            samples[i] = tsiScan(tsiElectrodes[index].channel);
+            scan_cycles = DWT->CYCCNT - start;
+            if(scan_cycles > *cycles){
+                *cycles = scan_cycles;
+            } else{
+            }
+            sum += samples[i];
+        }
+        if(*cycles >= max_cycles){
+            *snr = 0;
+        } else{
+        }
+        mean = sum / TSI_TUNE_SAMPLES;
+        dev_sum = 0;
+        for(i = 0; i < TSI_TUNE_SAMPLES; i++){
+            if(samples[i] > mean){
+                dev_sum += (samples[i] - mean);
+            } else{
+                dev_sum += (mean - samples[i]);
+            }
+        }
+        signal = ((mean*tsiElectrodes[index].limits.max_frac) >> 8);
+        if(dev_sum == 0){
+            elec_snr = 0xFFFFFFFFu;
+        } else{
+            elec_snr = (signal*TSI_TUNE_SAMPLES)/dev_sum;
+        }
+        if((elec_snr < *snr) && (*cycles < max_cycles)){
+            *snr = elec_snr;
+        } else{
+        }
+    }
+}
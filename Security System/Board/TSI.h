@@ -7,16 +7,24 @@
 #ifndef SOURCES_TSI_H_
 #define SOURCES_TSI_H_
 
-#define E1FLAG 0
-#define E2FLAG 1
+#define TSI_NUM_ELECTRODES 2    //Entries in tsiElectrodes[], at most 16
+#define TSI_E1_MASK 0x1u        //TSIGetSensors() bits, by table position
+#define TSI_E2_MASK 0x2u
+
+typedef struct{
+    INT32U mask;                //TSIGetSensors() value after the change
+    INT32U time;                //SysTickGetmsCount() of the change
+} TSI_EVENT;
 
 /********************************************************************
 * TSIInit - Initializes  and calibrates TSI
 *
-* Description:  Enables electrodes 0 and 1 for use within program. Calibrates
-*               the sensors based off of a control baseline and a small offset
-*               to ensure noise does not trigger the sensors yet light presses
-*               still get sensed.
+* Description:  Enables the electrodes in tsiElectrodes[]. Calibrates each
+*               sensor by averaging TSI_CAL_SAMPLES scans for the starting
+*               baseline and the mean deviation of those scans for the
+*               starting noise level. The touch levels are set from these,
+*               see TSITouch.c. Then starts LPTMR0 triggered scans with
+*               the out-of-range interrupt.
 *
 * Return value: None
 *
@@ -24,12 +32,13 @@
 ********************************************************************/
 void TSIInit(void);
 /********************************************************************
-* TSITask - Poll both TSI counters for values over calibrated TouchLevel
+* TSITask - Rotates the hardware scanned electrode
 *
-* Description:  Uses a state machine design that starts a scan for second electrode,
-*               while reading the current value for the first, then switches to
-*               reading the second electrode and starting scan for the first to
-*               ensure scanning is completed by the time the value is read.
+* Description:  Only one TSI channel is scanned by the hardware trigger at a
+*               time, so each slice the next electrode in the table is
+*               selected and its touch window is loaded into the threshold
+*               registers. The touch decisions themselves are made in
+*               TSI0_IRQHandler.
 *
 * Return value: None
 *
@@ -37,15 +46,59 @@ void TSIInit(void);
 ********************************************************************/
 void TSITask(void);
 /********************************************************************
-* TSIGetSensor - Sends status of electrodes (activated/idle)
+* TSIGetSensors - Sends status of electrodes (activated/idle)
+*
+* Description:  Bit n is set while electrode n of tsiElectrodes[] is touched.
+*
+* Return value: Bitmask of touched electrodes
+*
+* Arguments:    None
+********************************************************************/
+INT32U TSIGetSensors(void);
+/********************************************************************
+* TSIGetEvent - Takes the oldest touch transition from the queue
 *
-* Description:  With the electrode index as a parameter, returns state of
-*               corresponding sensor activation flag.
+* Description:  Every change of the touched bitmask is queued with its time
+*               by the TSI interrupt, so a consumer sees each press and
+*               release in order even if it runs later.
+*
+* Return value: 1 if an event was copied out, 0 if the queue was empty
+*
+* Arguments:    Pointer to the event to be filled
+********************************************************************/
+INT8U TSIGetEvent(TSI_EVENT *event);
+/********************************************************************
+* TSIProxEnter - Switches TSI0 to proximity mode
+*
+* Description:  One electrode is scanned with a longer integration and a
+*               lower threshold, and keeps scanning in LLS so TSI0 can wake
+*               the part through LLWU. Touch decisions stop until
+*               TSIProxExit().
 *
 * Return value: None
 *
 * Arguments:    None
 ********************************************************************/
-INT8U TSIGetSensor(INT8U electrode);
+void TSIProxEnter(void);
+/********************************************************************
+* TSIProxExit - Returns TSI0 to touch mode
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void TSIProxExit(void);
+/********************************************************************
+* TSIGetProximity - Returns whether an approach was seen then clears it
+*
+* Return value: 1 if the proximity level was crossed, else 0
+*
+* Arguments:    None
+********************************************************************/
+INT8U TSIGetProximity(void);
+/********************************************************************
+* Handler must be public for linker to see it.
+********************************************************************/
+void TSI0_IRQHandler(void);
 
 #endif /* SOURCES_TSI_H_ */
@@ -0,0 +1,246 @@
+/*******************************************************************************
+* TSIFilter.c - Filter kernels for the touch sensors. Electrode values are
+*               packed as signed 16 bit lanes, two per 32 bit word, so one
+*               Cortex-M4 SIMD instruction works on two electrodes at a time.
+*               The median uses __SSUB16 to set the GE flags and __SEL to
+*               pick per lane, the average uses the halving add __SHADD16.
+*               Lane-by-lane C reference versions are built alongside, and
+*               TSIFiltCheck() compares the two sets and times them. With
+*               TSI_FILT_SIMD_EN set to 0 only the C versions are built and
+*               used, which is how a host build gets them.
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#include "MCUType.h"
+#include "TSIFilter.h"
+
+#define TSI_FILT_CHECK_WORDS 64  //TSIFiltCheck() input words
+#define TSI_FILT_EDGE_WORDS 10   //tsiFiltEdges[] entries
+
+#if TSI_FILT_SIMD_EN
+/* Lane limits and signs, ahead of the pseudo-random words */
+static const INT32U tsiFiltEdges[TSI_FILT_EDGE_WORDS] = {
+    0x00000000u, 0x7FFF7FFFu, 0x80008000u, 0x7FFF8000u, 0x80007FFFu,
+    0xFFFFFFFFu, 0x00010001u, 0xFFFF0001u, 0x7FFF7FFFu, 0x80008000u
+};
+static INT32U tsiFiltWords[TSI_FILT_CHECK_WORDS];
+static volatile INT32U tsiFiltSink;
+
+static INT32U tsiFiltMin(INT32U a, INT32U b);
+static INT32U tsiFiltMax(INT32U a, INT32U b);
+static INT32U tsiFiltMedian3Simd(INT32U a, INT32U b, INT32U c);
+static INT32U tsiFiltMean4Simd(const INT32U *w);
+static INT32U tsiFiltAboveSimd(INT32U x, INT32U level);
+#endif
+static INT32U tsiFiltMedian3Ref(INT32U a, INT32U b, INT32U c);
+static INT32U tsiFiltMean4Ref(const INT32U *w);
+static INT32U tsiFiltAboveRef(INT32U x, INT32U level);
+
+/********************************************************************
+* TSIFiltMedian3 - Packed median of three
+*
+* Description:  Median of a, b and c for each 16 bit lane, as
+*               max(min(a,b), min(max(a,b),c)).
+*
+* Return value: Packed medians
+*
+* Arguments:    Three packed sample words
+********************************************************************/
+INT32U TSIFiltMedian3(INT32U a, INT32U b, INT32U c){
+#if TSI_FILT_SIMD_EN
+    return(tsiFiltMedian3Simd(a, b, c));
+#else
+    return(tsiFiltMedian3Ref(a, b, c));
+#endif
+}
+/********************************************************************
+* TSIFiltMean4 - Packed moving average of four
+*
+* Description:  Mean of four words for each 16 bit lane. Halving adds never
+*               overflow a lane, each one rounds down.
+*
+* Return value: Packed means
+*
+* Arguments:    Pointer to four packed words
+********************************************************************/
+INT32U TSIFiltMean4(const INT32U *w){
+#if TSI_FILT_SIMD_EN
+    return(tsiFiltMean4Simd(w));
+#else
+    return(tsiFiltMean4Ref(w));
+#endif
+}
+/********************************************************************
+* TSIFiltAbove - Packed greater than compare
+*
+* Description:  Compares each 16 bit lane of x against the same lane of level.
+*
+* Return value: 0xFFFF in lanes where x > level, 0 in the others
+*
+* Arguments:    Packed values and packed levels
+********************************************************************/
+INT32U TSIFiltAbove(INT32U x, INT32U level){
+#if TSI_FILT_SIMD_EN
+    return(tsiFiltAboveSimd(x, level));
+#else
+    return(tsiFiltAboveRef(x, level));
+#endif
+}
+#if TSI_FILT_SIMD_EN
+/********************************************************************
+* TSIFiltCheck - Cross-checks and times the SIMD and reference kernels
+*
+* Description:  Runs TSI_FILT_CHECK_WORDS words, the lane limits then a
+*               pseudo-random sequence, through all three kernels of each
+*               set and counts the words where the sets differ. Then times
+*               each set over the same words with the DWT cycle counter.
+*               The results are folded into tsiFiltSink so the timed calls
+*               can not be optimized away.
+*
+* Return value: None
+*
+* Arguments:    Where to put the mismatch count and cycles
+********************************************************************/
+void TSIFiltCheck(TSI_FILT_BENCH *bench){
+    INT32U fold = 0;
+    INT32U start;
+    INT32U seed = 1;
+    INT8U i;
+
+    for(i = 0; i < TSI_FILT_CHECK_WORDS; i++){
+        if(i < TSI_FILT_EDGE_WORDS){
+            tsiFiltWords[i] = tsiFiltEdges[i];
+        } else{
+            seed = (seed*1664525u) + 1013904223u;
+            tsiFiltWords[i] = seed;
+        }
+    }
+    bench->mismatches = 0;
+    for(i = 0; i < (TSI_FILT_CHECK_WORDS - 3); i++){
+        if((tsiFiltMedian3Simd(tsiFiltWords[i], tsiFiltWords[i + 1], tsiFiltWords[i + 2]) !=
+            tsiFiltMedian3Ref(tsiFiltWords[i], tsiFiltWords[i + 1], tsiFiltWords[i + 2])) ||
+           (tsiFiltMean4Simd(&tsiFiltWords[i]) != tsiFiltMean4Ref(&tsiFiltWords[i])) ||
+           (tsiFiltAboveSimd(tsiFiltWords[i], tsiFiltWords[i + 1]) !=
+            tsiFiltAboveRef(tsiFiltWords[i], tsiFiltWords[i + 1]))){
+            bench->mismatches++;
+        } else{
+        }
+    }
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    start = DWT->CYCCNT;
+    for(i = 0; i < (TSI_FILT_CHECK_WORDS - 3); i++){
+        fold ^= tsiFiltMedian3Simd(tsiFiltWords[i], tsiFiltWords[i + 1], tsiFiltWords[i + 2]);
+        fold ^= tsiFiltMean4Simd(&tsiFiltWords[i]);
+        fold ^= tsiFiltAboveSimd(tsiFiltWords[i], tsiFiltWords[i + 1]);
+    }
+    bench->simd_cycles = DWT->CYCCNT - start;
+    start = DWT->CYCCNT;
+    for(i = 0; i < (TSI_FILT_CHECK_WORDS - 3); i++){
+        fold ^= tsiFiltMedian3Ref(tsiFiltWords[i], tsiFiltWords[i + 1], tsiFiltWords[i + 2]);
+        fold ^= tsiFiltMean4Ref(&tsiFiltWords[i]);
+        fold ^= tsiFiltAboveRef(tsiFiltWords[i], tsiFiltWords[i + 1]);
+    }
+    bench->ref_cycles = DWT->CYCCNT - start;
+    tsiFiltSink = fold;
+}
+/********************************************************************
+* tsiFiltMin/tsiFiltMax - Packed minimum/maximum
+*
+* Description:  __SSUB16 sets GE for each lane where a >= b, __SEL then takes
+*               its first argument in lanes with GE set.
+********************************************************************/
+static INT32U tsiFiltMin(INT32U a, INT32U b){
+    (void)__SSUB16(a, b);
+    return(__SEL(b, a));
+}
+static INT32U tsiFiltMax(INT32U a, INT32U b){
+    (void)__SSUB16(a, b);
+    return(__SEL(a, b));
+}
+/********************************************************************
+* tsiFiltMedian3Simd/tsiFiltMean4Simd/tsiFiltAboveSimd - SIMD kernels
+*
+* Description:  Two lanes an instruction. The mean is three halving adds,
+*               the compare one __SSUB16 setting GE where level >= x.
+********************************************************************/
+static INT32U tsiFiltMedian3Simd(INT32U a, INT32U b, INT32U c){
+    return(tsiFiltMax(tsiFiltMin(a, b), tsiFiltMin(tsiFiltMax(a, b), c)));
+}
+static INT32U tsiFiltMean4Simd(const INT32U *w){
+    return(__SHADD16(__SHADD16(w[0], w[1]), __SHADD16(w[2], w[3])));
+}
+static INT32U tsiFiltAboveSimd(INT32U x, INT32U level){
+    (void)__SSUB16(level, x);
+    return(__SEL(0u, 0xFFFFFFFFu));
+}
+#endif
+/********************************************************************
+* tsiFiltMedian3Ref/tsiFiltMean4Ref/tsiFiltAboveRef - C reference kernels
+*
+* Description:  Lane by lane with the same rounding as the SIMD kernels.
+********************************************************************/
+static INT32U tsiFiltMedian3Ref(INT32U a, INT32U b, INT32U c){
+    INT32U out = 0;
+    INT16S va, vb, vc, lo, hi;
+    INT8U lane;
+
+    for(lane = 0; lane < TSI_FILT_LANES; lane++){
+        va = TSIFiltGetLane(a, lane);
+        vb = TSIFiltGetLane(b, lane);
+        vc = TSIFiltGetLane(c, lane);
+        lo = (va < vb) ? va : vb;
+        hi = (va < vb) ? vb : va;
+        hi = (hi < vc) ? hi : vc;
+        out = TSIFiltSetLane(out, lane, (lo > hi) ? lo : hi);
+    }
+    return(out);
+}
+static INT32U tsiFiltMean4Ref(const INT32U *w){
+    INT32U out = 0;
+    INT32S m01, m23;
+    INT8U lane;
+
+    for(lane = 0; lane < TSI_FILT_LANES; lane++){
+        m01 = ((INT32S)TSIFiltGetLane(w[0], lane) + TSIFiltGetLane(w[1], lane)) >> 1;
+        m23 = ((INT32S)TSIFiltGetLane(w[2], lane) + TSIFiltGetLane(w[3], lane)) >> 1;
+        out = TSIFiltSetLane(out, lane, (INT16S)((m01 + m23) >> 1));
+    }
+    return(out);
+}
+static INT32U tsiFiltAboveRef(INT32U x, INT32U level){
+    INT32U out = 0;
+    INT8U lane;
+
+    for(lane = 0; lane < TSI_FILT_LANES; lane++){
+        if(TSIFiltGetLane(x, lane) > TSIFiltGetLane(level, lane)){
+            out = TSIFiltSetLane(out, lane, -1);
+        } else{
+        }
+    }
+    return(out);
+}
+/********************************************************************
+* TSIFiltSetLane - Replaces one lane of a packed word
+*
+* Return value: The new packed word
+*
+* Arguments:    Packed word, lane index and the signed 16 bit value
+********************************************************************/
+INT32U TSIFiltSetLane(INT32U word, INT8U lane, INT16S value){
+    INT8U shift = (INT8U)(lane << 4);
+
+    return((word & ~(0xFFFFu << shift))|((INT32U)(INT16U)value << shift));
+}
+/********************************************************************
+* TSIFiltGetLane - Reads one lane of a packed word
+*
+* Return value: Signed 16 bit value of the lane
+*
+* Arguments:    Packed word and lane index
+********************************************************************/
+INT16S TSIFiltGetLane(INT32U word, INT8U lane){
+    return((INT16S)(INT16U)(word >> (lane << 4)));
+}
@@ -0,0 +1,80 @@
+/*******************************************************************************
+* TSIFilter.h - Project header file for TSIFilter.c
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#ifndef SOURCES_TSIFILTER_H_
+#define SOURCES_TSIFILTER_H_
+
+#ifndef TSI_FILT_SIMD_EN
+#define TSI_FILT_SIMD_EN 1      //0 builds only the C reference kernels, for a host
+#endif
+#define TSI_FILT_LANES 2        //Signed 16 bit electrode values per word
+
+typedef struct{
+    INT32U mismatches;          //Words where the two kernel sets differ
+    INT32U simd_cycles;         //Core clocks for the SIMD kernels over the words
+    INT32U ref_cycles;          //Same for the C reference kernels
+} TSI_FILT_BENCH;
+
+/********************************************************************
+* TSIFiltMedian3 - Packed median of three
+*
+* Description:  Median of a, b and c for each 16 bit lane.
+*
+* Return value: Packed medians
+*
+* Arguments:    Three packed sample words
+********************************************************************/
+INT32U TSIFiltMedian3(INT32U a, INT32U b, INT32U c);
+/********************************************************************
+* TSIFiltMean4 - Packed moving average of four
+*
+* Description:  Mean of four words for each 16 bit lane, rounded down.
+*
+* Return value: Packed means
+*
+* Arguments:    Pointer to four packed words
+********************************************************************/
+INT32U TSIFiltMean4(const INT32U *w);
+/********************************************************************
+* TSIFiltAbove - Packed greater than compare
+*
+* Description:  Compares each 16 bit lane of x against the same lane of level.
+*
+* Return value: 0xFFFF in lanes where x > level, 0 in the others
+*
+* Arguments:    Packed values and packed levels
+********************************************************************/
+INT32U TSIFiltAbove(INT32U x, INT32U level);
+/********************************************************************
+* TSIFiltCheck - Cross-checks and times the SIMD and reference kernels
+*
+* Description:  Only with TSI_FILT_SIMD_EN. Each word is run
+*               through the median, mean and compare of both, see
+*               TSIFilter.c for the words. Uses the DWT cycle counter.
+*
+* Return value: None
+*
+* Arguments:    Where to put the mismatch count and cycles
+********************************************************************/
+void TSIFiltCheck(TSI_FILT_BENCH *bench);
+/********************************************************************
+* TSIFiltSetLane - Replaces one lane of a packed word
+*
+* Return value: The new packed word
+*
+* Arguments:    Packed word, lane index and the signed 16 bit value
+********************************************************************/
+INT32U TSIFiltSetLane(INT32U word, INT8U lane, INT16S value);
+/********************************************************************
+* TSIFiltGetLane - Reads one lane of a packed word
+*
+* Return value: Signed 16 bit value of the lane
+*
+* Arguments:    Packed word and lane index
+********************************************************************/
+INT16S TSIFiltGetLane(INT32U word, INT8U lane);
+
+#endif /* SOURCES_TSIFILTER_H_ */
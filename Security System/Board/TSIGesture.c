@@ -0,0 +1,172 @@
+/*******************************************************************************
+* TSIGesture.c - Touch gesture classifier
+*
+* Description: Classifies the timestamped transitions queued by TSI.c:
+*              TAP    - one pad pressed and released before TSI_GEST_HOLD_MS,
+*                       a brush-past.
+*              HOLD   - one pad kept pressed for TSI_GEST_HOLD_MS.
+*              SLIDE  - a second pad pressed while the first is still down,
+*                       or within TSI_GEST_GAP_MS of releasing it. FWD is
+*                       toward the higher electrode bit, BACK the lower.
+*              Transitions are mapped to an input, and gestTable gives the
+*              next state and the gesture emitted. A TAP is only emitted
+*              once the slide window closes.
+*              TSIGestureFeed() and TSIGestureTimeout() use no hardware.
+*              TSIGestureTask() is the only user of TSI.c and SysTickDelay.c,
+*              through TSIGetEvent() and SysTickGetmsCount(), so a host
+*              build links this file with stand-ins for those two, see
+*              Tools/tsi_replay.c.
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#include "MCUType.h"
+#include "TSI.h"
+#include "TSIGesture.h"
+#include "SysTickDelay.h"
+
+typedef enum{GEST_IDLE, GEST_DOWN, GEST_HELD, GEST_GAP, GEST_SLID,
+             GEST_NUM_STATES} GEST_STATE;
+typedef enum{GEST_IN_PRESS, GEST_IN_OTHER, GEST_IN_RELEASE, GEST_IN_TIMEOUT,
+             GEST_NUM_INPUTS, GEST_IN_NONE = GEST_NUM_INPUTS} GEST_INPUT;
+
+typedef struct{
+    GEST_STATE next;
+    TSI_GESTURE gesture;
+} GEST_ENTRY;
+
+static const GEST_ENTRY gestTable[GEST_NUM_STATES][GEST_NUM_INPUTS] = {
+    /*           PRESS                    OTHER                        RELEASE                  TIMEOUT */
+    /*IDLE*/ {{GEST_DOWN,TSI_GEST_NONE},{GEST_DOWN,TSI_GEST_NONE},  {GEST_IDLE,TSI_GEST_NONE},{GEST_IDLE,TSI_GEST_NONE}},
+    /*DOWN*/ {{GEST_DOWN,TSI_GEST_NONE},{GEST_SLID,TSI_GEST_SLIDE_FWD},{GEST_GAP,TSI_GEST_NONE},{GEST_HELD,TSI_GEST_HOLD}},
+    /*HELD*/ {{GEST_HELD,TSI_GEST_NONE},{GEST_HELD,TSI_GEST_NONE},  {GEST_IDLE,TSI_GEST_NONE},{GEST_HELD,TSI_GEST_NONE}},
+    /*GAP */ {{GEST_DOWN,TSI_GEST_TAP}, {GEST_SLID,TSI_GEST_SLIDE_FWD},{GEST_GAP,TSI_GEST_NONE},{GEST_IDLE,TSI_GEST_TAP}},
+    /*SLID*/ {{GEST_SLID,TSI_GEST_NONE},{GEST_SLID,TSI_GEST_NONE},  {GEST_IDLE,TSI_GEST_NONE},{GEST_SLID,TSI_GEST_NONE}}
+};
+static const INT32U gestWindow[GEST_NUM_STATES] = {
+    0, TSI_GEST_HOLD_MS, 0, TSI_GEST_GAP_MS, 0     //0 is no timeout
+};
+
+static GEST_STATE gestState = GEST_IDLE;
+static INT32U gestEnterTime;
+static INT32U gestLastMask;
+static INT32U gestPadMask;          //Pad that started the gesture
+static TSI_GESTURE gestBuffer = TSI_GEST_NONE;
+
+static void gestStep(GEST_INPUT input, INT32U newbits, INT32U time);
+
+/********************************************************************
+* TSIGestureTask - Feeds queued touch transitions to the classifier
+*
+* Description:  Drains TSIGetEvent() and checks for an expired hold or
+*               slide window. Does nothing else when no touch is in
+*               progress.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void TSIGestureTask(void){
+    TSI_EVENT event;
+
+    while(TSIGetEvent(&event) != 0){
+        TSIGestureFeed(event.mask, event.time);
+    }
+    TSIGestureTimeout(SysTickGetmsCount());
+}
+/********************************************************************
+* TSIGestureGet - Returns the last gesture then clears it
+*
+* Description:  Read-once handshake like GetKey().
+*
+* Return value: Last gesture, or TSI_GEST_NONE
+*
+* Arguments:    None
+********************************************************************/
+TSI_GESTURE TSIGestureGet(void){
+    TSI_GESTURE gesture = gestBuffer;
+
+    gestBuffer = TSI_GEST_NONE;
+    return(gesture);
+}
+/********************************************************************
+* TSIGestureFeed - Steps the classifier with one touch transition
+*
+* Description:  A window that expired before this transition is
+*               applied first, at the transition's own time, so a late
+*               drain classifies the same as a prompt one. Only newly
+*               pressed pads count as a press, so letting go of one pad
+*               of a slide is ignored until all are released.
+*
+* Return value: None
+*
+* Arguments:    Touched bitmask after the change and its time in ms
+********************************************************************/
+void TSIGestureFeed(INT32U mask, INT32U time){
+    INT32U newbits = mask & ~gestLastMask;
+    GEST_INPUT input;
+
+    TSIGestureTimeout(time);
+    if(mask == 0){
+        input = GEST_IN_RELEASE;
+    } else if(newbits == 0){
+        input = GEST_IN_NONE;
+    } else if((gestPadMask != 0) && ((newbits & ~gestPadMask) != 0)){
+        input = GEST_IN_OTHER;
+    } else{
+        input = GEST_IN_PRESS;
+    }
+    gestLastMask = mask;
+    if(input != GEST_IN_NONE){
+        gestStep(input, newbits, time);
+    } else{
+    }
+}
+/********************************************************************
+* TSIGestureTimeout - Steps the classifier if its window has expired
+*
+* Return value: None
+*
+* Arguments:    Current time in ms
+********************************************************************/
+void TSIGestureTimeout(INT32U now){
+    if((gestWindow[gestState] != 0) &&
+       ((now - gestEnterTime) >= gestWindow[gestState])){
+        gestStep(GEST_IN_TIMEOUT, 0, gestEnterTime + gestWindow[gestState]);
+    } else{
+    }
+}
+/********************************************************************
+* gestStep - Applies one table entry
+*
+* Description:  Entering DOWN records the starting pad, entering IDLE
+*               forgets it. A slide toward a lower bit is turned into
+*               SLIDE_BACK here rather than doubling the table.
+*
+* Return value: None
+*
+* Arguments:    Input, newly pressed pads and the time of the input
+********************************************************************/
+static void gestStep(GEST_INPUT input, INT32U newbits, INT32U time){
+    GEST_ENTRY entry = gestTable[gestState][input];
+
+    if((entry.gesture == TSI_GEST_SLIDE_FWD) && (newbits < gestPadMask)){
+        entry.gesture = TSI_GEST_SLIDE_BACK;
+    } else{
+    }
+    if(entry.gesture != TSI_GEST_NONE){
+        gestBuffer = entry.gesture;
+    } else{
+    }
+    if(entry.next == GEST_DOWN){
+        gestPadMask = newbits;
+    } else if(entry.next == GEST_IDLE){
+        gestPadMask = 0;
+    } else{
+    }
+    if(entry.next != gestState){
+        gestEnterTime = time;
+    } else{
+    }
+    gestState = entry.next;
+}
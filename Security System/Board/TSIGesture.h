@@ -0,0 +1,58 @@
+/*******************************************************************************
+* TSIGesture.h - Project header file for TSIGesture.c
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#ifndef SOURCES_TSIGESTURE_H_
+#define SOURCES_TSIGESTURE_H_
+
+#define TSI_GEST_HOLD_MS 600    //Press held this long is deliberate
+#define TSI_GEST_GAP_MS 150     //Max release to next press for a slide
+
+typedef enum{TSI_GEST_NONE, TSI_GEST_TAP, TSI_GEST_HOLD,
+             TSI_GEST_SLIDE_FWD, TSI_GEST_SLIDE_BACK} TSI_GESTURE;
+
+/********************************************************************
+* TSIGestureTask - Feeds queued touch transitions to the classifier
+*
+* Description:  Drains TSIGetEvent() and checks for an expired hold or
+*               slide window. Does nothing else when no touch is in
+*               progress.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void TSIGestureTask(void);
+/********************************************************************
+* TSIGestureGet - Returns the last gesture then clears it
+*
+* Description:  Read-once handshake like GetKey().
+*
+* Return value: Last gesture, or TSI_GEST_NONE
+*
+* Arguments:    None
+********************************************************************/
+TSI_GESTURE TSIGestureGet(void);
+/********************************************************************
+* TSIGestureFeed - Steps the classifier with one touch transition
+*
+* Description:  Hardware free so touch traces can be replayed through
+*               it on a host, see Tools/tsi_replay.c.
+*
+* Return value: None
+*
+* Arguments:    Touched bitmask after the change and its time in ms
+********************************************************************/
+void TSIGestureFeed(INT32U mask, INT32U time);
+/********************************************************************
+* TSIGestureTimeout - Steps the classifier if its window has expired
+*
+* Return value: None
+*
+* Arguments:    Current time in ms
+********************************************************************/
+void TSIGestureTimeout(INT32U now);
+
+#endif /* SOURCES_TSIGESTURE_H_ */
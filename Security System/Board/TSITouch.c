@@ -0,0 +1,252 @@
+/*******************************************************************************
+* TSITouch.c - Touch decision for the electrodes of TSI.c. Each electrode
+*              keeps a fixed point baseline that follows slow drift while
+*              the pad is idle, and a touch threshold set from the measured
+*              noise on that pad. The decision is made on a median of three
+*              then moving average of four of the samples, see TSIFilter.c,
+*              so one noisy scan can not set or clear a pad.
+*              No hardware is touched. TSI.c feeds it the TSICNT of each
+*              scan and loads the levels into the threshold registers, and
+*              Tools/tsi_replay.c feeds it recorded traces on a host.
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#include "MCUType.h"
+#include "TSI.h"
+#include "TSIFilter.h"
+#include "TSITouch.h"
+
+#define TSI_BASE_SHIFT 6        //Baseline filter weight, 1/64 per sample
+#define TSI_NOISE_SHIFT 4       //Noise filter weight, 1/16 per sample
+#define TSI_MED_LEN 3           //Median window, samples
+#define TSI_AVG_LEN 4           //Moving average of medians
+#define TSI_LANE_WORDS ((TSI_NUM_ELECTRODES + TSI_FILT_LANES - 1)/TSI_FILT_LANES)
+
+static const TSI_TOUCH_LIMITS *tsiLimits[TSI_NUM_ELECTRODES];
+static INT16U tsiTouchLevel[TSI_NUM_ELECTRODES];
+static INT16U tsiReleaseLevel[TSI_NUM_ELECTRODES];
+static INT32U tsiBaselineQ8[TSI_NUM_ELECTRODES];
+static INT32U tsiNoiseQ8[TSI_NUM_ELECTRODES];
+static volatile INT32U tsiSensorMask;
+static INT32U tsiTouchDelta[TSI_LANE_WORDS];    //Packed per electrode lane
+static INT32U tsiReleaseDelta[TSI_LANE_WORDS];
+static INT32U tsiRawDelta[TSI_MED_LEN][TSI_LANE_WORDS];
+static INT32U tsiMedDelta[TSI_AVG_LEN][TSI_LANE_WORDS];
+static INT8U tsiRawPos[TSI_NUM_ELECTRODES];
+static INT8U tsiMedPos[TSI_NUM_ELECTRODES];
+
+static void tsiSetLevels(INT8U index);
+
+/********************************************************************
+* TSITouchStats - Baseline and noise of a run of samples
+*
+* Description:  The mean is the baseline and the mean absolute deviation
+*               from it is the noise. Both are returned in Q8 so that the
+*               filters in TSITouchSample() do not lose the fraction of
+*               small updates.
+*
+* Return value: None
+*
+* Arguments:    Samples, how many, and the two results
+********************************************************************/
+void TSITouchStats(const INT16U *samples, INT8U n, INT32U *base_q8, INT32U *noise_q8){
+    INT32U sum = 0;
+    INT32U dev_sum = 0;
+    INT32U mean;
+    INT8U i;
+
+    for(i = 0; i < n; i++){
+        sum += samples[i];
+    }
+    mean = sum / n;
+    for(i = 0; i < n; i++){
+        if(samples[i] > mean){
+            dev_sum += (samples[i] - mean);
+        } else{
+            dev_sum += (mean - samples[i]);
+        }
+    }
+    *base_q8 = (sum << TSI_Q) / n;
+    *noise_q8 = (dev_sum << TSI_Q) / n;
+}
+/********************************************************************
+* TSITouchInit - Starts an electrode idle from its calibration
+*
+* Description:  Clears the electrode's bit and its lanes of the filter
+*               windows, then sets its levels, see tsiSetLevels().
+*
+* Return value: None
+*
+* Arguments:    Electrode index, its limits (kept), baseline and noise Q8
+********************************************************************/
+void TSITouchInit(INT8U index, const TSI_TOUCH_LIMITS *limits, INT32U base_q8, INT32U noise_q8){
+    INT8U word = (INT8U)(index / TSI_FILT_LANES);
+    INT8U lane = (INT8U)(index % TSI_FILT_LANES);
+    INT8U i;
+
+    tsiLimits[index] = limits;
+    tsiBaselineQ8[index] = base_q8;
+    tsiNoiseQ8[index] = noise_q8;
+    tsiSensorMask &= ~(1uL << index);
+    for(i = 0; i < TSI_MED_LEN; i++){
+        tsiRawDelta[i][word] = TSIFiltSetLane(tsiRawDelta[i][word], lane, 0);
+    }
+    for(i = 0; i < TSI_AVG_LEN; i++){
+        tsiMedDelta[i][word] = TSIFiltSetLane(tsiMedDelta[i][word], lane, 0);
+    }
+    tsiRawPos[index] = 0;
+    tsiMedPos[index] = 0;
+    tsiSetLevels(index);
+}
+/********************************************************************
+* TSITouchSample - Touch decision and baseline tracking for one sample
+*
+* Description:  The sample's delta from baseline goes into the electrode's
+*               lane of the median window, the median into its lane of the
+*               moving average, and the average is compared with the touch
+*               and release deltas for the whole packed word at once. An idle
+*               pad sets its bit once the average is over the touch delta and
+*               a touched pad clears it once under the release delta.
+*               While the pad is idle and the raw count is under the touch
+*               level it is also filtered into the baseline with weight
+*               1/2^TSI_BASE_SHIFT and its deviation into the noise with
+*               weight 1/2^TSI_NOISE_SHIFT, both in Q8, and the levels are
+*               updated. While the pad is touched the baseline and noise are
+*               frozen so a long press is not learned as the new baseline.
+*
+* Return value: 1 if the touched bitmask changed, else 0
+*
+* Arguments:    Electrode index and its TSICNT
+********************************************************************/
+INT8U TSITouchSample(INT8U index, INT16U count){
+    INT8U word = (INT8U)(index / TSI_FILT_LANES);
+    INT8U lane = (INT8U)(index % TSI_FILT_LANES);
+    INT32U bit = (1uL << index);
+    INT8U changed = 0;
+    INT32S diff_q8;
+    INT32S dev_q8;
+    INT32S delta;
+    INT32U median;
+    INT32U filtered;
+    INT32U avg_in[TSI_AVG_LEN];
+    INT8U i;
+
+    diff_q8 = (INT32S)((INT32U)count << TSI_Q) - (INT32S)tsiBaselineQ8[index];
+    delta = (diff_q8 >> TSI_Q);
+    if(delta > 32767){
+        delta = 32767;
+    } else if(delta < -32768){
+        delta = -32768;
+    } else{
+    }
+    tsiRawDelta[tsiRawPos[index]][word] = TSIFiltSetLane(tsiRawDelta[tsiRawPos[index]][word], lane, (INT16S)delta);
+    tsiRawPos[index] = (INT8U)((tsiRawPos[index] + 1) % TSI_MED_LEN);
+    median = TSIFiltMedian3(tsiRawDelta[0][word], tsiRawDelta[1][word], tsiRawDelta[2][word]);
+    tsiMedDelta[tsiMedPos[index]][word] = TSIFiltSetLane(tsiMedDelta[tsiMedPos[index]][word], lane, TSIFiltGetLane(median, lane));
+    tsiMedPos[index] = (INT8U)((tsiMedPos[index] + 1) % TSI_AVG_LEN);
+    for(i = 0; i < TSI_AVG_LEN; i++){
+        avg_in[i] = tsiMedDelta[i][word];
+    }
+    filtered = TSIFiltMean4(avg_in);
+
+    if((tsiSensorMask & bit) == 0){
+        if(TSIFiltGetLane(TSIFiltAbove(filtered, tsiTouchDelta[word]), lane) != 0){
+            tsiSensorMask |= bit;
+            changed = 1;
+        } else if(count <= tsiTouchLevel[index]){
+            tsiBaselineQ8[index] = (INT32U)((INT32S)tsiBaselineQ8[index] + (diff_q8 >> TSI_BASE_SHIFT));
+            if(diff_q8 < 0){
+                diff_q8 = -diff_q8;
+            } else{
+            }
+            dev_q8 = diff_q8 - (INT32S)tsiNoiseQ8[index];
+            tsiNoiseQ8[index] = (INT32U)((INT32S)tsiNoiseQ8[index] + (dev_q8 >> TSI_NOISE_SHIFT));
+            tsiSetLevels(index);
+        } else{
+        }
+    } else{
+        if(TSIFiltGetLane(TSIFiltAbove(tsiReleaseDelta[word], filtered), lane) != 0){
+            tsiSensorMask &= ~bit;
+            changed = 1;
+        } else{
+        }
+    }
+    return(changed);
+}
+/********************************************************************
+* TSITouchMask - Bit n is set while electrode n is touched
+*
+* Return value: Bitmask of touched electrodes
+*
+* Arguments:    None
+********************************************************************/
+INT32U TSITouchMask(void){
+    return(tsiSensorMask);
+}
+/********************************************************************
+* TSITouchLevel/TSITouchReleaseLevel - Absolute TSICNT levels
+*
+* Return value: The level
+*
+* Arguments:    Electrode index
+********************************************************************/
+INT16U TSITouchLevel(INT8U index){
+    return(tsiTouchLevel[index]);
+}
+INT16U TSITouchReleaseLevel(INT8U index){
+    return(tsiReleaseLevel[index]);
+}
+/********************************************************************
+* TSITouchBaseQ8 - Current baseline of an electrode in Q8
+*
+* Return value: Baseline
+*
+* Arguments:    Electrode index
+********************************************************************/
+INT32U TSITouchBaseQ8(INT8U index){
+    return(tsiBaselineQ8[index]);
+}
+/********************************************************************
+* tsiSetLevels - Sets touch and release levels from baseline and noise
+*
+* Description:  The touch delta is the electrode's noise_mult times the mean
+*               noise, kept between its min_frac and max_frac of the baseline.
+*               A quiet pad then gets a low threshold (more sensitive) while a
+*               noisy one is raised far enough to not trigger on its own. The
+*               limits are fractions so they follow the counts of whatever
+*               scan parameters tsiTune() picked. The release level is half
+*               way back, which gives hysteresis.
+*               The absolute levels are for the threshold registers, the
+*               deltas from baseline are for the filtered decision.
+*
+* Return value: None
+*
+* Arguments:    Electrode index
+********************************************************************/
+static void tsiSetLevels(INT8U index){
+    const TSI_TOUCH_LIMITS *limits = tsiLimits[index];
+    INT8U word = (INT8U)(index / TSI_FILT_LANES);
+    INT8U lane = (INT8U)(index % TSI_FILT_LANES);
+    INT32U base;
+    INT32U delta;
+    INT32U level;
+
+    base = (tsiBaselineQ8[index] >> TSI_Q);
+    delta = ((limits->noise_mult*tsiNoiseQ8[index]) >> TSI_Q);
+    if(delta < ((base*limits->min_frac) >> 8)){
+        delta = ((base*limits->min_frac) >> 8);
+    } else if(delta > ((base*limits->max_frac) >> 8)){
+        delta = ((base*limits->max_frac) >> 8);
+    } else{
+    }
+    level = base + delta;
+    if(level > 0xFFFFu){
+        level = 0xFFFFu;
+    } else{
+    }
+    tsiTouchLevel[index] = (INT16U)level;
+    tsiReleaseLevel[index] = (INT16U)(base + (delta >> 1));
+    tsiTouchDelta[word] = TSIFiltSetLane(tsiTouchDelta[word], lane, (INT16S)delta);
+    tsiReleaseDelta[word] = TSIFiltSetLane(tsiReleaseDelta[word], lane, (INT16S)(delta >> 1));
+}
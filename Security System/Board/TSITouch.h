@@ -0,0 +1,80 @@
+/*******************************************************************************
+* TSITouch.h - Project header file for TSITouch.c
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#ifndef SOURCES_TSITOUCH_H_
+#define SOURCES_TSITOUCH_H_
+
+#define TSI_Q 8                 //Fraction bits of baseline and noise (Q8)
+
+typedef struct{
+    INT8U noise_mult;           //Touch delta in multiples of mean noise
+    INT8U min_frac;             //Lower limit on touch delta, baseline/256ths
+    INT8U max_frac;             //Upper limit, also the expected touch signal
+} TSI_TOUCH_LIMITS;
+
+/********************************************************************
+* TSITouchStats - Baseline and noise of a run of samples
+*
+* Description:  The mean is the baseline and the mean absolute deviation
+*               from it is the noise, both in Q8.
+*
+* Return value: None
+*
+* Arguments:    Samples, how many, and the two results
+********************************************************************/
+void TSITouchStats(const INT16U *samples, INT8U n, INT32U *base_q8, INT32U *noise_q8);
+/********************************************************************
+* TSITouchInit - Starts an electrode idle from its calibration
+*
+* Description:  Clears its filter windows and sets its levels.
+*
+* Return value: None
+*
+* Arguments:    Electrode index, its limits (kept), baseline and noise Q8
+********************************************************************/
+void TSITouchInit(INT8U index, const TSI_TOUCH_LIMITS *limits, INT32U base_q8, INT32U noise_q8);
+/********************************************************************
+* TSITouchSample - Touch decision and baseline tracking for one sample
+*
+* Description:  Touches no hardware, so recorded TSICNT traces can be
+*               replayed through it on a host, see Tools/tsi_replay.c.
+*
+* Return value: 1 if the touched bitmask changed, else 0
+*
+* Arguments:    Electrode index and its TSICNT
+********************************************************************/
+INT8U TSITouchSample(INT8U index, INT16U count);
+/********************************************************************
+* TSITouchMask - Bit n is set while electrode n is touched
+*
+* Return value: Bitmask of touched electrodes
+*
+* Arguments:    None
+********************************************************************/
+INT32U TSITouchMask(void);
+/********************************************************************
+* TSITouchLevel/TSITouchReleaseLevel - Absolute TSICNT levels
+*
+* Description:  An idle pad is touched above its touch level, a touched
+*               pad released under its release level. For the threshold
+*               registers, the decision itself is on the filtered deltas.
+*
+* Return value: The level
+*
+* Arguments:    Electrode index
+********************************************************************/
+INT16U TSITouchLevel(INT8U index);
+INT16U TSITouchReleaseLevel(INT8U index);
+/********************************************************************
+* TSITouchBaseQ8 - Current baseline of an electrode in Q8
+*
+* Return value: Baseline
+*
+* Arguments:    Electrode index
+********************************************************************/
+INT32U TSITouchBaseQ8(INT8U index);
+
+#endif /* SOURCES_TSITOUCH_H_ */
@@ -0,0 +1,195 @@
+/*******************************************************************************
+* ADCSeq.c - A DMA driven ADC0 sequencer. Each PIT1 period ADC0 converts every
+*            channel in adcSeqChannels[] once and the results land in
+*            adcSeqRing without the CPU:
+*            DMA1 - gated by PIT1, writes the first channel to ADC0_SC1A,
+*                   which starts the scan in software trigger mode.
+*            DMA2 - requested by ADC0 conversion complete, copies ADC0_RA
+*                   into the next ring entry then links to DMA3.
+*            DMA3 - only run by that link, writes the next channel from
+*                   adcSeqNext[] to ADC0_SC1A, starting the next conversion.
+*                   The last entry is ADCH 31, which stops ADC0 until the
+*                   next PIT1 period.
+*            The ring is interleaved, scan by scan, and wraps by DMOD so it
+*            is aligned to its size. Adding an input is one more entry in
+*            adcSeqChannels[] and a slot define.
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#include "MCUType.h"
+#include "ADCSeq.h"
+
+#define ADC_SEQ_DMA_KICK 1          //DMAMUX channel 1 is gated by PIT1
+#define ADC_SEQ_DMA_RESULT 2
+#define ADC_SEQ_DMA_NEXT 3
+#define ADC_SEQ_DMAMUX_ADC0 40
+#define ADC_SEQ_DMAMUX_ALWAYS 61    //Always enabled source for the kick
+#define ADC_SEQ_ADCH_OFF 31         //Disables the ADC, ends a scan
+#define ADC_SEQ_RING_ENTRIES (ADC_SEQ_DEPTH*ADC_SEQ_NUM_SLOTS)
+#define ADC_SEQ_RING_BYTES (ADC_SEQ_RING_ENTRIES*2)
+#define ADC_SEQ_RING_DMOD 8         //log2(ADC_SEQ_RING_BYTES)
+#if ((1 << ADC_SEQ_RING_DMOD) != ADC_SEQ_RING_BYTES)
+#error "ADC_SEQ_RING_DMOD must match the ring size"
+#endif
+#if (ADC_SEQ_RING_ENTRIES > 511)
+#error "Ring does not fit a linked CITER"
+#endif
+
+static const INT32U adcSeqChannels[ADC_SEQ_NUM_SLOTS] = {
+    ADC_SC1_ADCH(3),                //ADC_SEQ_MCP9701
+    ADC_SC1_ADCH(26)                //ADC_SEQ_DIE_TEMP
+};
+static INT32U adcSeqNext[ADC_SEQ_NUM_SLOTS];
+static INT16U adcSeqRing[ADC_SEQ_RING_ENTRIES] __attribute__((aligned(ADC_SEQ_RING_BYTES)));
+
+static void adcSeqADC0Config(void);
+
+/********************************************************************
+* ADCSeqInit - Sets up ADC0 and the three sequencer DMA channels
+*
+* Description:  ADC0 is left at 16 bit, 7.5MHz ADCK with 32 sample hardware
+*               averaging, in software trigger mode with DMA requests on.
+*               adcSeqNext[] is adcSeqChannels[] moved up by one with
+*               ADC_SEQ_ADCH_OFF at the end. DMA2 links to DMA3 on every
+*               minor loop and, since the last minor loop does not link, on
+*               the major loop as well.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void ADCSeqInit(void){
+    INT8U i;
+
+    for(i = 0; i < (ADC_SEQ_NUM_SLOTS - 1); i++){
+        adcSeqNext[i] = adcSeqChannels[i + 1];
+    }
+    adcSeqNext[ADC_SEQ_NUM_SLOTS - 1] = ADC_SC1_ADCH(ADC_SEQ_ADCH_OFF);
+
+    SIM_SCGC6 |= (SIM_SCGC6_ADC0_MASK|SIM_SCGC6_DMAMUX_MASK);
+    SIM_SCGC7 |= SIM_SCGC7_DMA_MASK;
+    adcSeqADC0Config();
+
+    DMAMUX_CHCFG(ADC_SEQ_DMA_NEXT) = DMAMUX_CHCFG_ENBL(0);
+    DMA_SADDR(ADC_SEQ_DMA_NEXT) = DMA_SADDR_SADDR(adcSeqNext);
+    DMA_ATTR(ADC_SEQ_DMA_NEXT) = (DMA_ATTR_SSIZE(2) | DMA_ATTR_SMOD(0) | DMA_ATTR_DMOD(0) | DMA_ATTR_DSIZE(2));
+    DMA_SOFF(ADC_SEQ_DMA_NEXT) = 4;
+    DMA_SLAST(ADC_SEQ_DMA_NEXT) = DMA_SLAST_SLAST(-(INT32S)sizeof(adcSeqNext));
+    DMA_DADDR(ADC_SEQ_DMA_NEXT) = DMA_DADDR_DADDR(&ADC0_SC1A);
+    DMA_DOFF(ADC_SEQ_DMA_NEXT) = DMA_DOFF_DOFF(0);
+    DMA_NBYTES_MLNO(ADC_SEQ_DMA_NEXT) = DMA_NBYTES_MLNO_NBYTES(4);
+    DMA_CITER_ELINKNO(ADC_SEQ_DMA_NEXT) = DMA_CITER_ELINKNO_CITER(ADC_SEQ_NUM_SLOTS);
+    DMA_BITER_ELINKNO(ADC_SEQ_DMA_NEXT) = DMA_BITER_ELINKNO_BITER(ADC_SEQ_NUM_SLOTS);
+    DMA_DLAST_SGA(ADC_SEQ_DMA_NEXT) = DMA_DLAST_SGA_DLASTSGA(0);
+    DMA_CSR(ADC_SEQ_DMA_NEXT) = 0;
+
+    DMAMUX_CHCFG(ADC_SEQ_DMA_RESULT) = DMAMUX_CHCFG_ENBL(0);
+    DMA_SADDR(ADC_SEQ_DMA_RESULT) = DMA_SADDR_SADDR(&ADC0_RA);
+    DMA_ATTR(ADC_SEQ_DMA_RESULT) = (DMA_ATTR_SSIZE(1) | DMA_ATTR_SMOD(0) | DMA_ATTR_DMOD(ADC_SEQ_RING_DMOD) | DMA_ATTR_DSIZE(1));
+    DMA_SOFF(ADC_SEQ_DMA_RESULT) = 0;
+    DMA_SLAST(ADC_SEQ_DMA_RESULT) = DMA_SLAST_SLAST(0);
+    DMA_DADDR(ADC_SEQ_DMA_RESULT) = DMA_DADDR_DADDR(adcSeqRing);
+    DMA_DOFF(ADC_SEQ_DMA_RESULT) = DMA_DOFF_DOFF(2);
+    DMA_NBYTES_MLNO(ADC_SEQ_DMA_RESULT) = DMA_NBYTES_MLNO_NBYTES(2);
+    DMA_CITER_ELINKYES(ADC_SEQ_DMA_RESULT) = (DMA_CITER_ELINKYES_ELINK(1)|DMA_CITER_ELINKYES_LINKCH(ADC_SEQ_DMA_NEXT)|
+                                              DMA_CITER_ELINKYES_CITER(ADC_SEQ_RING_ENTRIES));
+    DMA_BITER_ELINKYES(ADC_SEQ_DMA_RESULT) = (DMA_BITER_ELINKYES_ELINK(1)|DMA_BITER_ELINKYES_LINKCH(ADC_SEQ_DMA_NEXT)|
+                                              DMA_BITER_ELINKYES_BITER(ADC_SEQ_RING_ENTRIES));
+    DMA_DLAST_SGA(ADC_SEQ_DMA_RESULT) = DMA_DLAST_SGA_DLASTSGA(0);
+    DMA_CSR(ADC_SEQ_DMA_RESULT) = (DMA_CSR_MAJORELINK(1)|DMA_CSR_MAJORLINKCH(ADC_SEQ_DMA_NEXT));
+    DMAMUX_CHCFG(ADC_SEQ_DMA_RESULT) = DMAMUX_CHCFG_ENBL(1)|DMAMUX_CHCFG_SOURCE(ADC_SEQ_DMAMUX_ADC0);
+
+    DMAMUX_CHCFG(ADC_SEQ_DMA_KICK) = DMAMUX_CHCFG_ENBL(0);
+    DMA_SADDR(ADC_SEQ_DMA_KICK) = DMA_SADDR_SADDR(adcSeqChannels);
+    DMA_ATTR(ADC_SEQ_DMA_KICK) = (DMA_ATTR_SSIZE(2) | DMA_ATTR_SMOD(0) | DMA_ATTR_DMOD(0) | DMA_ATTR_DSIZE(2));
+    DMA_SOFF(ADC_SEQ_DMA_KICK) = 0;
+    DMA_SLAST(ADC_SEQ_DMA_KICK) = DMA_SLAST_SLAST(0);
+    DMA_DADDR(ADC_SEQ_DMA_KICK) = DMA_DADDR_DADDR(&ADC0_SC1A);
+    DMA_DOFF(ADC_SEQ_DMA_KICK) = DMA_DOFF_DOFF(0);
+    DMA_NBYTES_MLNO(ADC_SEQ_DMA_KICK) = DMA_NBYTES_MLNO_NBYTES(4);
+    DMA_CITER_ELINKNO(ADC_SEQ_DMA_KICK) = DMA_CITER_ELINKNO_CITER(1);
+    DMA_BITER_ELINKNO(ADC_SEQ_DMA_KICK) = DMA_BITER_ELINKNO_BITER(1);
+    DMA_DLAST_SGA(ADC_SEQ_DMA_KICK) = DMA_DLAST_SGA_DLASTSGA(0);
+    DMA_CSR(ADC_SEQ_DMA_KICK) = 0;
+    DMAMUX_CHCFG(ADC_SEQ_DMA_KICK) = DMAMUX_CHCFG_ENBL(1)|DMAMUX_CHCFG_TRIG(1)|DMAMUX_CHCFG_SOURCE(ADC_SEQ_DMAMUX_ALWAYS);
+
+    DMA_SERQ = DMA_SERQ_SERQ(ADC_SEQ_DMA_RESULT);
+    DMA_SERQ = DMA_SERQ_SERQ(ADC_SEQ_DMA_KICK);
+}
+/********************************************************************
+* ADCSeqScanIndex - Returns the scan being written
+*
+* Description:  From the result channel's CITER, which counts down from the
+*               ring size and reloads when the ring wraps.
+*
+* Return value: Ring index 0 to ADC_SEQ_DEPTH-1
+*
+* Arguments:    None
+********************************************************************/
+INT8U ADCSeqScanIndex(void){
+    INT32U entry;
+
+    entry = ADC_SEQ_RING_ENTRIES - (DMA_CITER_ELINKYES(ADC_SEQ_DMA_RESULT) & DMA_CITER_ELINKYES_CITER_MASK);
+    if(entry >= ADC_SEQ_RING_ENTRIES){
+        entry = 0;
+    } else{
+    }
+    return((INT8U)(entry / ADC_SEQ_NUM_SLOTS));
+}
+/********************************************************************
+* ADCSeqRead - Returns one result from the ring
+*
+* Return value: 16 bit ADC result
+*
+* Arguments:    Ring index of the scan and the channel slot
+********************************************************************/
+INT16U ADCSeqRead(INT8U scan, INT8U slot){
+    return(adcSeqRing[(scan*ADC_SEQ_NUM_SLOTS) + slot]);
+}
+/********************************************************************
+* ADCSeqPause - Stops the sequencer and frees ADC0
+*
+* Description:  Clears the kick request, then waits for a scan already
+*               started to reach ADC_SEQ_ADCH_OFF, at most one scan. ADC0
+*               DMA requests are turned off so the caller can use ADC0 in
+*               any mode. PIT1 periods while paused are not scanned.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void ADCSeqPause(void){
+    DMA_CERQ = DMA_CERQ_CERQ(ADC_SEQ_DMA_KICK);
+    while(((DMA_CSR(ADC_SEQ_DMA_KICK) & DMA_CSR_ACTIVE_MASK) != 0) ||
+          ((ADC0_SC1A & ADC_SC1_ADCH_MASK) != ADC_SC1_ADCH(ADC_SEQ_ADCH_OFF))){
+    }
+    ADC0_SC2 = 0;
+}
+/********************************************************************
+* ADCSeqResume - Gives ADC0 back to the sequencer
+*
+* Description:  ADC0 is set up again as in ADCSeqInit(), the DMA channels
+*               were left where the last scan ended.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void ADCSeqResume(void){
+    adcSeqADC0Config();
+    DMA_SERQ = DMA_SERQ_SERQ(ADC_SEQ_DMA_KICK);
+}
+/********************************************************************
+* adcSeqADC0Config - Sets ADC0 up for the sequencer
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+static void adcSeqADC0Config(void){
+    ADC0_CFG1 = (ADC_CFG1_ADIV(3)|ADC_CFG1_MODE(3)|ADC_CFG1_ADICLK(0));
+    ADC0_SC2 = ADC_SC2_DMAEN(1);
+    ADC0_SC3 = (ADC_SC3_AVGE(1)|ADC_SC3_AVGS(3));
+    ADC0_SC1A = ADC_SC1_ADCH(ADC_SEQ_ADCH_OFF);
+}
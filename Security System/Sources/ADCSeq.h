@@ -0,0 +1,65 @@
+/*******************************************************************************
+* ADCSeq.h - Project header file for ADCSeq.c
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#ifndef SOURCES_ADCSEQ_H_
+#define SOURCES_ADCSEQ_H_
+
+#define ADC_SEQ_RATE_HZ 64          //Scans per second, from PIT1
+#define ADC_SEQ_DEPTH 64            //Scans kept in the result ring
+#define ADC_SEQ_NUM_SLOTS 2         //Power of 2, see adcSeqChannels[]
+#define ADC_SEQ_MCP9701 0           //Slot of DADP3, external sensor
+#define ADC_SEQ_DIE_TEMP 1          //Slot of the on-chip temperature sensor
+
+/********************************************************************
+* ADCSeqInit - Sets up ADC0 and the three sequencer DMA channels
+*
+* Description:  ADC0 must be calibrated first. PIT1 sets the scan rate,
+*               see TempADCPIT1Init().
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void ADCSeqInit(void);
+/********************************************************************
+* ADCSeqScanIndex - Returns the scan being written
+*
+* Description:  Scans before this one, back to ADC_SEQ_DEPTH, are complete.
+*
+* Return value: Ring index 0 to ADC_SEQ_DEPTH-1
+*
+* Arguments:    None
+********************************************************************/
+INT8U ADCSeqScanIndex(void);
+/********************************************************************
+* ADCSeqRead - Returns one result from the ring
+*
+* Return value: 16 bit ADC result
+*
+* Arguments:    Ring index of the scan and the channel slot
+********************************************************************/
+INT16U ADCSeqRead(INT8U scan, INT8U slot);
+/********************************************************************
+* ADCSeqPause - Stops the sequencer and frees ADC0
+*
+* Description:  Returns once any scan in progress has finished. ADC0 is
+*               left calibrated with its DMA requests off.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void ADCSeqPause(void);
+/********************************************************************
+* ADCSeqResume - Gives ADC0 back to the sequencer
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void ADCSeqResume(void);
+
+#endif /* SOURCES_ADCSEQ_H_ */
@@ -0,0 +1,77 @@
+/*******************************************************************************
+* ADPCM.c - IMA ADPCM decoder for clips stored in flash
+*
+* Description: 4 bits a sample, a quarter of 16 bit PCM. No hardware is
+*              touched so the host encoder links this file to produce its
+*              prediction, which keeps the two bit exact.
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#include "MCUType.h"
+#include "ADPCM.h"
+
+#define ADPCM_INDEX_MAX 88
+
+static const INT16U adpcmStep[ADPCM_INDEX_MAX + 1] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+    12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const INT8S adpcmIndexAdj[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+/********************************************************************
+* ADPCMDecode - Decodes one IMA ADPCM code
+*
+* Description:  The difference is (code magnitude + 1/2)*step/4 built from
+*               shifts, bit 3 of the code is the sign. The sample saturates
+*               to 16 bits and the step index moves by adpcmIndexAdj.
+*
+* Return value: The 16 bit sample
+*
+* Arguments:    Decoder state, 4 bit code
+********************************************************************/
+INT16S ADPCMDecode(ADPCM_STATE *state, INT8U code){
+    INT32S step = adpcmStep[state->index];
+    INT32S diff = step >> 3;
+    INT32S sample;
+    INT32S index;
+
+    if((code & 0x4u) != 0){
+        diff += step;
+    } else{
+    }
+    if((code & 0x2u) != 0){
+        diff += (step >> 1);
+    } else{
+    }
+    if((code & 0x1u) != 0){
+        diff += (step >> 2);
+    } else{
+    }
+    if((code & 0x8u) != 0){
+        sample = state->predictor - diff;
+    } else{
+        sample = state->predictor + diff;
+    }
+    if(sample > 32767){
+        sample = 32767;
+    } else if(sample < -32768){
+        sample = -32768;
+    } else{
+    }
+    index = (INT32S)state->index + adpcmIndexAdj[code & 0x7u];
+    if(index < 0){
+        index = 0;
+    } else if(index > ADPCM_INDEX_MAX){
+        index = ADPCM_INDEX_MAX;
+    } else{
+    }
+    state->predictor = (INT16S)sample;
+    state->index = (INT8U)index;
+    return((INT16S)sample);
+}
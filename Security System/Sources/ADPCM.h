@@ -0,0 +1,35 @@
+/*******************************************************************************
+* ADPCM.h - Project header file for ADPCM.c
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#ifndef SOURCES_ADPCM_H_
+#define SOURCES_ADPCM_H_
+
+typedef struct{
+    INT16S predictor;           //Last decoded sample
+    INT8U index;                //Step table index, 0-88
+} ADPCM_STATE;
+
+typedef struct{
+    const INT8U *data;          //Two codes a byte, first in the low nibble
+    INT32U samples;
+    INT32U rate_hz;
+    ADPCM_STATE start;          //Decoder state before the first code
+} ADPCM_CLIP;
+
+/********************************************************************
+* ADPCMDecode - Decodes one IMA ADPCM code
+*
+* Description:  Standard IMA/DVI decoding, bit exact with the encoder in
+*               Tools/adpcm_encode.c which uses this same function, and
+*               checked against reference vectors by Tools/adpcm_test.c.
+*
+* Return value: The 16 bit sample
+*
+* Arguments:    Decoder state, 4 bit code
+********************************************************************/
+INT16S ADPCMDecode(ADPCM_STATE *state, INT8U code);
+
+#endif /* SOURCES_ADPCM_H_ */
@@ -0,0 +1,13 @@
+/*******************************************************************************
+* AlarmChime.h - Project header file for AlarmChime.c
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#ifndef SOURCES_ALARMCHIME_H_
+#define SOURCES_ALARMCHIME_H_
+
+/* Two note chime, 0.8s at 9.6kHz, played as the alarm goes off */
+extern const ADPCM_CLIP AlarmChime;
+
+#endif /* SOURCES_ALARMCHIME_H_ */
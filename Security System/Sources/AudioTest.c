@@ -0,0 +1,254 @@
+/*******************************************************************************
+* AudioTest.c - Loopback self-test of the alarm sound. DAC0_OUT is also ADC0
+*               input 23, so the sound is measured where it leaves the chip
+*               with no extra wiring.
+*               The sequencer is paused for the test and ADC0 is triggered
+*               by PIT2 at AUDIO_TEST_FS_HZ, each result stored by
+*               ADC0_IRQHandler. AudioTestTask runs the stored samples
+*               through one Goertzel filter per harmonic of DMA_TONE_HZ,
+*               at most AUDIO_TEST_SLICE_SAMPLES a slice. The block is a
+*               whole number of tone periods so every harmonic is exactly
+*               on a bin, with no window needed.
+*               The tone table has equal harmonics, so the test passes if
+*               the fundamental is at least AUDIO_TEST_MIN_MV and every
+*               harmonic is within 2x of it. A stuck or disconnected DAC,
+*               a dead DMA chain or a wrong table all fail.
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#include "MCUType.h"
+#include "ADCSeq.h"
+#include "ADPCM.h"
+#include "DMA.h"
+#include "DMAWave.h"
+#include "Goertzel.h"
+#include "AudioTest.h"
+
+#define AUDIO_TEST_BUS_CLK_HZ 60000000
+#define AUDIO_TEST_FS_HZ 4800           //ADC0 rate, DMA_FS_HZ/4
+#define PIT2_TIMER_VALUE ((AUDIO_TEST_BUS_CLK_HZ/AUDIO_TEST_FS_HZ) - 1)
+#define AUDIO_TEST_N 480                //100ms block, 10Hz bins
+#define AUDIO_TEST_BIN (((INT32U)DMA_TONE_HZ*AUDIO_TEST_N)/AUDIO_TEST_FS_HZ)
+#define AUDIO_TEST_SLICE_SAMPLES 64     //More than arrive in a slice
+#define AUDIO_TEST_SETTLE_SLICES 5      //Gain ramp done before sampling
+#define AUDIO_TEST_ADCH_DAC0 23
+#define AUDIO_TEST_ADC0_TRG_PIT2 6
+#define AUDIO_TEST_MID 0x8000           //DAC mid scale in 16 bit ADC codes
+#define AUDIO_TEST_VREF_MV 3300
+#define AUDIO_TEST_MIN_MV 20
+#if (((DMA_TONE_HZ*AUDIO_TEST_N) % AUDIO_TEST_FS_HZ) != 0)
+#error "AUDIO_TEST_N must hold a whole number of tone periods"
+#endif
+#if ((2*DMA_TONE_HZ*AUDIO_TEST_HARMONICS) >= AUDIO_TEST_FS_HZ)
+#error "Harmonics checked must be under AUDIO_TEST_FS_HZ/2"
+#endif
+#if (AUDIO_TEST_HARMONICS > DMA_WAVE_HARMONICS)
+#error "The tone table has fewer harmonics"
+#endif
+
+/* 2cos(2pi*k/n) = 2sin(2pi*(k + n/4)/n), in GOERTZEL_Q and rounded */
+#define AUDIO_TEST_COS(k) DMA_WAVE_SIN(1, (k) + (AUDIO_TEST_N/4), AUDIO_TEST_N)
+#define AUDIO_TEST_COEFF(h) ((INT32S)((2.0*(1 << GOERTZEL_Q)*AUDIO_TEST_COS((h)*AUDIO_TEST_BIN)) + \
+                            ((AUDIO_TEST_COS((h)*AUDIO_TEST_BIN) < 0.0) ? -0.5 : 0.5)))
+
+typedef enum{AUDIO_TEST_IDLE, AUDIO_TEST_SETTLE, AUDIO_TEST_SAMPLE} AUDIO_TEST_STATE;
+
+static const INT32S audioTestCoeff[AUDIO_TEST_HARMONICS] = {
+    AUDIO_TEST_COEFF(1), AUDIO_TEST_COEFF(2), AUDIO_TEST_COEFF(3),
+    AUDIO_TEST_COEFF(4), AUDIO_TEST_COEFF(5)
+};
+static AUDIO_TEST_STATE audioTestState = AUDIO_TEST_IDLE;
+static INT8U audioTestSlices;
+static INT16S audioTestBuf[AUDIO_TEST_N];
+static volatile INT16U audioTestCount;  //Samples stored by the ISR
+static INT16U audioTestDone;            //Samples through the filters
+static GOERTZEL audioTestFilt[AUDIO_TEST_HARMONICS];
+static AUDIO_TEST_RESULT audioTestResult;
+
+static void audioTestADCStart(void);
+static void audioTestFinish(void);
+
+/********************************************************************
+* AudioTestStart - Starts a loopback self-test of the alarm sound
+*
+* Description:  The tone is started here, sampling after
+*               AUDIO_TEST_SETTLE_SLICES so the gain ramp is over.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void AudioTestStart(void){
+    INT8U h;
+
+    if(audioTestState == AUDIO_TEST_IDLE){
+        for(h = 0; h < AUDIO_TEST_HARMONICS; h++){
+            GoertzelInit(&audioTestFilt[h], audioTestCoeff[h]);
+        }
+        audioTestCount = 0;
+        audioTestDone = 0;
+        audioTestSlices = 0;
+        DMAStopCadence();
+        DMASetSound(DMA_SOUND_TONE);
+        DMAAlarmOn();
+        audioTestState = AUDIO_TEST_SETTLE;
+    } else{
+    }
+}
+/********************************************************************
+* AudioTestTask - Runs the self-test a piece each slice
+*
+* Description:  Filters the samples stored since the last slice, up to
+*               AUDIO_TEST_SLICE_SAMPLES times AUDIO_TEST_HARMONICS filter
+*               steps, so never more than about 20us. Samples arrive at
+*               48 a slice so the filters keep up, and the last of them
+*               ends the test.
+*               This task runs every slice.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void AudioTestTask(void){
+    INT16U num;
+    INT8U h;
+
+    switch(audioTestState){
+        case(AUDIO_TEST_SETTLE):
+            audioTestSlices++;
+            if(audioTestSlices >= AUDIO_TEST_SETTLE_SLICES){
+                audioTestADCStart();
+                audioTestState = AUDIO_TEST_SAMPLE;
+            } else{
+            }
+            break;
+        case(AUDIO_TEST_SAMPLE):
+            num = audioTestCount - audioTestDone;
+            if(num > AUDIO_TEST_SLICE_SAMPLES){
+                num = AUDIO_TEST_SLICE_SAMPLES;
+            } else{
+            }
+            for(h = 0; h < AUDIO_TEST_HARMONICS; h++){
+                GoertzelRun(&audioTestFilt[h], &audioTestBuf[audioTestDone], num);
+            }
+            audioTestDone += num;
+            if(audioTestDone >= AUDIO_TEST_N){
+                audioTestFinish();
+                audioTestState = AUDIO_TEST_IDLE;
+            } else{
+            }
+            break;
+        default:
+            break;
+    }
+}
+/********************************************************************
+* AudioTestBusy - Returns whether a self-test is running
+*
+* Return value: 1 from AudioTestStart() until the result is ready, else 0
+*
+* Arguments:    None
+********************************************************************/
+INT8U AudioTestBusy(void){
+    return((INT8U)(audioTestState != AUDIO_TEST_IDLE));
+}
+/********************************************************************
+* AudioTestGetResult - Copies the result of the last finished self-test
+*
+* Return value: None
+*
+* Arguments:    Where to copy the result
+********************************************************************/
+void AudioTestGetResult(AUDIO_TEST_RESULT *result){
+    *result = audioTestResult;
+}
+/********************************************************************
+* ADC0_IRQHandler - ADC0 conversion complete, self-test only
+*
+* Description:  Stores the result less mid scale. PIT2 is stopped after
+*               the last one.
+*
+* Handler must be public for linker to see it.
+********************************************************************/
+void ADC0_IRQHandler(void){
+    INT32S code = (INT32S)(ADC0_RA & 0xFFFFu);
+    INT16U count = audioTestCount;
+
+    if(count < AUDIO_TEST_N){
+        audioTestBuf[count] = (INT16S)(code - AUDIO_TEST_MID);
+        count++;
+        audioTestCount = count;
+    } else{
+    }
+    if(count >= AUDIO_TEST_N){
+        PIT_TCTRL2 = 0;
+    } else{
+    }
+}
+/********************************************************************
+* audioTestADCStart - Takes ADC0 from the sequencer for the test
+*
+* Description:  ADC0 keeps its 16 bit, 7.5MHz setup, with 4 sample
+*               averaging (about 15us, flat to well past the top
+*               harmonic), PIT2 as alternate hardware trigger and the
+*               conversion complete interrupt on DAC0_OUT.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+static void audioTestADCStart(void){
+    ADCSeqPause();
+    ADC0_SC3 = (ADC_SC3_AVGE(1)|ADC_SC3_AVGS(0));
+    SIM_SOPT7 = ((SIM_SOPT7 & ~(SIM_SOPT7_ADC0TRGSEL_MASK|SIM_SOPT7_ADC0PRETRGSEL_MASK)) |
+                 SIM_SOPT7_ADC0ALTTRGEN(1)|SIM_SOPT7_ADC0TRGSEL(AUDIO_TEST_ADC0_TRG_PIT2));
+    ADC0_SC2 = ADC_SC2_ADTRG(1);
+    ADC0_SC1A = (ADC_SC1_AIEN(1)|ADC_SC1_ADCH(AUDIO_TEST_ADCH_DAC0));
+    NVIC_ClearPendingIRQ(ADC0_IRQn);
+    NVIC_EnableIRQ(ADC0_IRQn);
+    PIT_LDVAL2 = PIT2_TIMER_VALUE;
+    PIT_TCTRL2 = PIT_TCTRL_TEN(1);
+}
+/********************************************************************
+* audioTestFinish - Ends the test and keeps the result
+*
+* Description:  Gives ADC0 back to the sequencer and stops the tone. The
+*               amplitudes are converted from ADC codes to mV.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+static void audioTestFinish(void){
+    INT32U amp;
+    INT8U pass = 1;
+    INT8U h;
+
+    NVIC_DisableIRQ(ADC0_IRQn);
+    ADC0_SC1A = ADC_SC1_ADCH(31);
+    SIM_SOPT7 &= ~SIM_SOPT7_ADC0ALTTRGEN_MASK;
+    ADCSeqResume();
+    DMAAlarmOff();
+    for(h = 0; h < AUDIO_TEST_HARMONICS; h++){
+        amp = GoertzelAmplitude(&audioTestFilt[h], AUDIO_TEST_N);
+        audioTestResult.amp_mv[h] = (INT16U)(((amp*AUDIO_TEST_VREF_MV) + 0x8000u) >> 16);
+    }
+    if(audioTestResult.amp_mv[0] < AUDIO_TEST_MIN_MV){
+        pass = 0;
+    } else{
+    }
+    for(h = 1; h < AUDIO_TEST_HARMONICS; h++){
+        if(((2u*audioTestResult.amp_mv[h]) < audioTestResult.amp_mv[0]) ||
+           (audioTestResult.amp_mv[h] > (2u*audioTestResult.amp_mv[0]))){
+            pass = 0;
+        } else{
+        }
+    }
+    if(pass != 0){
+        audioTestResult.status = AUDIO_TEST_PASS;
+    } else{
+        audioTestResult.status = AUDIO_TEST_FAIL;
+    }
+    audioTestResult.seq++;
+}
@@ -0,0 +1,64 @@
+/*******************************************************************************
+* AudioTest.h - Project header file for AudioTest.c
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#ifndef SOURCES_AUDIOTEST_H_
+#define SOURCES_AUDIOTEST_H_
+
+#define AUDIO_TEST_HARMONICS 5      //Fundamental and 4 harmonics checked
+
+typedef enum{AUDIO_TEST_NONE, AUDIO_TEST_PASS, AUDIO_TEST_FAIL} AUDIO_TEST_STATUS;
+
+typedef struct{
+    AUDIO_TEST_STATUS status;   //AUDIO_TEST_NONE until the first run ends
+    INT32U seq;                 //Counts finished runs
+    INT16U amp_mv[AUDIO_TEST_HARMONICS];    //Peak amplitude at DAC0_OUT, mV
+} AUDIO_TEST_RESULT;
+
+/********************************************************************
+* AudioTestStart - Starts a loopback self-test of the alarm sound
+*
+* Description:  Plays the steady tone and measures DAC0_OUT with ADC0 for
+*               the fundamental and its harmonics. The sound must be off
+*               and left alone until AudioTestBusy() returns 0. Ignored
+*               while a test runs.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void AudioTestStart(void);
+/********************************************************************
+* AudioTestTask - Runs the self-test a piece each slice
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void AudioTestTask(void);
+/********************************************************************
+* AudioTestBusy - Returns whether a self-test is running
+*
+* Return value: 1 from AudioTestStart() until the result is ready, else 0
+*
+* Arguments:    None
+********************************************************************/
+INT8U AudioTestBusy(void);
+/********************************************************************
+* AudioTestGetResult - Copies the result of the last finished self-test
+*
+* Return value: None
+*
+* Arguments:    Where to copy the result
+********************************************************************/
+void AudioTestGetResult(AUDIO_TEST_RESULT *result);
+/********************************************************************
+* ADC0_IRQHandler - ADC0 conversion complete, self-test only
+*
+* Handler must be public for linker to see it.
+********************************************************************/
+void ADC0_IRQHandler(void);
+
+#endif /* SOURCES_AUDIOTEST_H_ */
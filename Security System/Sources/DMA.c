@@ -1,40 +1,219 @@
 /*******************************************************************************
 * DMA.c -   A module of initializing DMA0, DAC0, and PIT0 to feed 12bit values
-*           for a sinusoidal wave of 300Hz with 4 harmonies at 600Hz, 900Hz,
-*           1200Hz, and 1500Hz. These values are taken by the DMA to the DAC
-*           with triggers from the PIT.
+*           to the DAC with triggers from the PIT. Channel 0 always runs
+*           scatter/gather chains of 32 byte TCDs in RAM. Normally two TCDs,
+*           one per half of a ping-pong buffer, link to each other and
+*           interrupt at their end, then the half just left is refilled
+*           while the other plays.
+*           Samples come from dmaWaveTable, a wave with 4 harmonics, read at
+*           any frequency with a phase accumulator, so the sound can be a
+*           steady tone, a swept siren or pulsed, and can be changed at any
+*           refill with no glitch. An ADPCM clip can be played over the
+*           sound, decoded from flash a half at a time.
+*           A cadence instead links TCDs that play a fixed tone table, with
+*           SMOD wrapping the source, or silence for a set time each, so the
+*           DMA plays the whole pattern with no CPU at all. Since every
+*           TCD has ESG set the live DLAST_SGA is always a link, and
+*           changing it switches pattern at the end of the current step.
+*           Every refill goes through a gain stage that ramps to the volume
+*           when the alarm is on and to 0 when off, so starting and stopping
+*           never clicks. Cadences play RAM copies of the tone tables made
+*           at the volume by the same stage, and every tone step is an
+*           attack, a sustain and a decay TCD, the attack and decay reading
+*           DMA_ENV_SAMPLES long ramped copies, so cadence tones never
+*           click either. A cadence is only left from a silent step.
+*           With DMA_DAC_BUF_EN the DAC's own 16 word buffer is used instead
+*           of one DMA request per sample: PDB0 triggers the DAC, which
+*           steps its read pointer, and the watermark and read pointer top
+*           flags request a burst of 8 samples into the half the DAC has
+*           just played, so there are two requests per 16 samples.
 *
 * Created on: Dec 7, 2017
 * Author: Anthony Needles
 *******************************************************************************/
 #include "MCUType.h"
 #include "K65TWR_GPIO.h"
+#include "ADPCM.h"
 #include "DMA.h"
+#include "DMAWave.h"
 
-const INT16U dmaWaveTable[] = {0x800, 0xA4C, 0xC46, 0xDA9, 0xE4C, 0xE2B, 0xD61,
-                            0xC24, 0xABB, 0x96A, 0x86B, 0x7DE, 0x7C8, 0x815,
-                            0x89B, 0x92C, 0x999, 0x9C5, 0x9A5, 0x943, 0x8B8,
-                            0x82A, 0x7B9, 0x780, 0x788, 0x7C7, 0x829, 0x88D,
-                            0x8D6, 0x8ED, 0x8C9, 0x873, 0x7FF, 0x78C, 0x736,
-                            0x712, 0x729, 0x772, 0x7D6, 0x838, 0x877, 0x87F,
-                            0x846, 0x7D5, 0x747, 0x6BC, 0x65A, 0x63A, 0x666,
-                            0x6D3, 0x764, 0x7EA, 0x837, 0x821, 0x794, 0x695,
-                            0x544, 0x3DB, 0x29E, 0x1D4, 0x1B3, 0x256, 0x3B9,
-                            0x5B3};
+#define DMA_BUS_CLK_HZ 60000000
+#define DMA_HALF_SAMPLES 64             //3.3ms per half at DMA_FS_HZ
+#define DMA_DAC_BITS 12
+#define DMA_TABLE_BITS 6
+#define DMA_WAVE_N (1u << DMA_TABLE_BITS)   //dmaWaveTable samples, must match the table
+#define DMA_FRAC_BITS 16                //Phase bits used to interpolate
+#define DMA_PHASE_INC(hz) ((INT32U)((((INT64U)(hz)) << 32)/DMA_FS_HZ))
+#define DMA_SIREN_LOW_HZ 300
+#define DMA_SIREN_HIGH_HZ 900
+#define DMA_SIREN_HALVES 150            //Halves per sweep up or down, 0.5s
+#define DMA_SIREN_STEP ((DMA_PHASE_INC(DMA_SIREN_HIGH_HZ) - DMA_PHASE_INC(DMA_SIREN_LOW_HZ))/DMA_SIREN_HALVES)
+#define DMA_PULSE_HALVES 60             //Halves on, then off, 200ms
+#define DMA_SILENCE 0x800u              //DAC mid scale
+#define DMA_CLIP_FRAC_BITS 16           //Clip position fraction
+#define DMA_PCM_SHIFT (16 - DMA_DAC_BITS)
+#define DMA_TONE_B_BITS 5               //dmaToneBTable, 32 samples
+#define DMA_CADENCE_TCDS 40             //Room for all cadence steps, 3 a tone
+#define DMA_ENV_SAMPLES 256             //Cadence attack and decay, 13ms
+#define DMA_TCD_ALIGN 32
+#define DMA_GAIN_ONE 0x10000            //Q16 unity gain
+#define DMA_RAMP_HALVES 6               //0 to full volume in 20ms
+#define DMA_SILENCE_PAIR ((DMA_SILENCE << 16) | DMA_SILENCE)
+#if DMA_DAC_BUF_EN
+#define DMA_BURST 8                     //Samples per request, half the DAC buffer
+#define DMA_DAC_WORDS 16
+#define DMA_DAC_DMOD 5                  //Destination wraps over the 32 byte buffer
+#define DMA_DAC_DOFF 2
+#define DMA_DAC_DADDR (&DAC_DATL_REG(DAC0, DMA_BURST))  //Top flag first, see DMADAC0Init
+#define DMA_MUX_SOURCE 45               //DAC0
+#define DMA_MUX_TRIG 0
+#define DMA_PDB_INTERVALS 20            //DAC triggers per PDB0 count
+#define DMA_PDB_MOD (((PIT0_TIMER_VALUE + 1)*DMA_PDB_INTERVALS) - 1)
+#if (DMA_PDB_MOD > 0xFFFF)
+#error "PDB0 modulus does not fit, lower DMA_PDB_INTERVALS"
+#endif
+#else
+#define DMA_BURST 1
+#define DMA_DAC_DMOD 0
+#define DMA_DAC_DOFF 0
+#define DMA_DAC_DADDR (&DAC0_DAT0L)
+#define DMA_MUX_SOURCE 60               //Always on, gated by PIT0
+#define DMA_MUX_TRIG 1
+#endif
+
+#if (((PIT0_TIMER_VALUE + 1)*DMA_FS_HZ) != DMA_BUS_CLK_HZ)
+#error "PIT0_TIMER_VALUE does not give DMA_FS_HZ"
+#endif
+#if ((2*DMA_SIREN_HIGH_HZ*DMA_WAVE_HARMONICS) >= DMA_FS_HZ)
+#error "dmaWaveTable harmonics alias at the highest siren frequency"
+#endif
+#if (DMA_WAVE_N <= (2*DMA_WAVE_HARMONICS))
+#error "dmaWaveTable too short for its harmonics"
+#endif
+
+typedef struct{
+    INT32U saddr;
+    INT16S soff;
+    INT16U attr;
+    INT32U nbytes;
+    INT32S slast;
+    INT32U daddr;
+    INT16S doff;
+    INT16U citer;
+    INT32U dlast_sga;
+    INT16U csr;
+    INT16U biter;
+} DMA_TCD;
+
+typedef enum{DMA_TONE_OFF, DMA_TONE_A, DMA_TONE_B} DMA_TONE;
+
+typedef struct{
+    DMA_TONE tone;
+    INT16U ms;                  //Rounded down to whole periods, 1700 max
+} DMA_STEP;
+
+typedef struct{
+    const DMA_STEP *steps;
+    INT8U num_steps;
+} DMA_PATTERN;
+
+/* 300Hz with 4 harmonics at 600Hz, 900Hz, 1200Hz, and 1500Hz, all equal.
+ * Word aligned for dmaScale(). */
+const INT16U dmaWaveTable[DMA_WAVE_N] __attribute__((aligned(4))) =
+    DMA_WAVE_TABLE(64, DMA_DAC_BITS, 1, 1, 1, 1, 1);
+/* Tone B, the same wave an octave up at 600Hz */
+static const INT16U dmaToneBTable[1u << DMA_TONE_B_BITS] __attribute__((aligned(4))) =
+    DMA_WAVE_TABLE(32, DMA_DAC_BITS, 1, 1, 1, 1, 1);
+/* Tables at the volume for cadences, aligned to their size for SMOD */
+static INT16U dmaToneARam[DMA_WAVE_N] __attribute__((aligned(2*DMA_WAVE_N)));
+static INT16U dmaToneBRam[1u << DMA_TONE_B_BITS] __attribute__((aligned(2u << DMA_TONE_B_BITS)));
+/* Attack and decay, whole periods of each table ramped 0 to the volume and back */
+static INT16U dmaToneAUp[DMA_ENV_SAMPLES] __attribute__((aligned(4)));
+static INT16U dmaToneADown[DMA_ENV_SAMPLES] __attribute__((aligned(4)));
+static INT16U dmaToneBUp[DMA_ENV_SAMPLES] __attribute__((aligned(4)));
+static INT16U dmaToneBDown[DMA_ENV_SAMPLES] __attribute__((aligned(4)));
+static const INT16U dmaSilence = DMA_SILENCE;
+
+/* Temporal-3 evacuation pattern, three 0.5s beeps then 1.5s off */
+static const DMA_STEP dmaTemporal3[] = {
+    {DMA_TONE_A, 500}, {DMA_TONE_OFF, 500}, {DMA_TONE_A, 500}, {DMA_TONE_OFF, 500},
+    {DMA_TONE_A, 500}, {DMA_TONE_OFF, 1500}
+};
+/* Two tone, alternating every 0.4s */
+static const DMA_STEP dmaHiLo[] = {
+    {DMA_TONE_A, 400}, {DMA_TONE_B, 400}
+};
+/* Three short tone A, a gap, a long tone B */
+static const DMA_STEP dmaTriple[] = {
+    {DMA_TONE_A, 150}, {DMA_TONE_OFF, 50}, {DMA_TONE_A, 150}, {DMA_TONE_OFF, 50},
+    {DMA_TONE_A, 150}, {DMA_TONE_OFF, 200}, {DMA_TONE_B, 600}, {DMA_TONE_OFF, 400}
+};
+/* In DMA_CADENCE order */
+static const DMA_PATTERN dmaPatterns[] = {
+    {dmaTemporal3, sizeof(dmaTemporal3)/sizeof(dmaTemporal3[0])},
+    {dmaHiLo, sizeof(dmaHiLo)/sizeof(dmaHiLo[0])},
+    {dmaTriple, sizeof(dmaTriple)/sizeof(dmaTriple[0])}
+};
+
+static DMA_TCD dmaPingTCD[2] __attribute__((aligned(DMA_TCD_ALIGN)));
+static DMA_TCD dmaCadenceTCD[DMA_CADENCE_TCDS] __attribute__((aligned(DMA_TCD_ALIGN)));
+static DMA_TCD *dmaCadenceHead[sizeof(dmaPatterns)/sizeof(dmaPatterns[0])];
+
+static INT16U dmaBuffer[2*DMA_HALF_SAMPLES] __attribute__((aligned(4)));
+static volatile INT8U dmaCadenceOn;
+static volatile INT8U dmaCadenceStop;   //Leave the cadence at the next decay
+static volatile INT8U dmaAlarmOn;
+static volatile INT32S dmaVolume = DMA_GAIN_ONE;     //Q16
+static INT32S dmaGain;                  //Q16, at the end of the last refill
+static INT32S dmaGainPrev;              //Q16, at the end of the one before
+static INT32U dmaRefillCycles;          //Worst refill, core clocks
+static volatile DMA_SOUND dmaSound = DMA_SOUND_TONE;
+static DMA_SOUND dmaSoundNow = DMA_SOUND_TONE;
+static INT32U dmaPhase;
+static INT32U dmaPhaseInc = DMA_PHASE_INC(DMA_TONE_HZ);
+static INT16U dmaHalfCount;
+static INT8U dmaRising;
+static const ADPCM_CLIP *volatile dmaClipNext;
+static const ADPCM_CLIP *dmaClip;
+static ADPCM_STATE dmaClipState;
+static INT32U dmaClipPos;               //Codes decoded
+static INT32U dmaClipFrac;              //Between dmaClipPrev and dmaClipCur
+static INT32U dmaClipStep;              //Clip rate/DMA_FS_HZ
+static INT16S dmaClipPrev;
+static INT16S dmaClipCur;
+
+static void dmaNextHalf(void);
+static void dmaFill(INT16U *half);
+static void dmaFillClip(INT16U *half);
+static void dmaSetTCD(DMA_TCD *tcd, const void *src, INT16S soff, INT8U smod, INT16U citer,
+                      const DMA_TCD *next, INT16U csr);
+static void dmaBuildCadences(void);
+static DMA_TCD *dmaSetTone(DMA_TCD *tcd, const INT16U *sustain, const INT16U *up, const INT16U *down,
+                           INT8U smod, INT32U samples);
+static void dmaScaleTones(void);
+static void dmaEndCadence(void);
+static void dmaScale(INT16U *dst, const INT16U *src, INT16U samples, INT32S gain, INT32S step);
+static void dmaGainHalf(INT16U *half);
+static INT32S dmaSMULWB(INT32S gain, INT32U pair);
+static INT32S dmaSMULWT(INT32S gain, INT32U pair);
+static void dmaClockOn(void);
+static void dmaClockOff(void);
 
 /********************************************************************
 * DMAInit - Initializes DMA0
 *
-* Description:  Enables DMA for use with transferring data in dmaWaveTable to
-*               DAC0. Uses PIT0 for triggering. Disables the DMAMUX, the gives
-*               the source table address, 16bit data size, 2byte increments, -128
-*               end address change (return to original address). For destination
-*               the address is the DAC0 data register, 0 byte offset, 16 bit size.
-*               Minor loop size increment of 2 byes, with 64 samples total.
-*               Scatter/gather processing turned on. The DMAMUX is then reenabled
-*               with DMAMUX 0 selected.
-*
-*
+* Description:  Enables DMA for use with transferring data in dmaBuffer to
+*               DAC0. Uses PIT0 for triggering, or the DAC buffer flags with
+*               DMA_DAC_BUF_EN. Disables the DMAMUX, the gives
+*               builds the TCDs, one for each half of the buffer, 16bit data
+*               size, 2byte increments, a half of samples in the major loop,
+*               interrupt at major completion, each linked to the other by
+*               scatter/gather. For destination the address is the DAC0 data
+*               register, 0 byte offset, 16 bit size. The first half's TCD is
+*               loaded into the channel. The DMAMUX is then reenabled with
+*               DMAMUX 0 selected. Both halves are filled before the first
+*               request. The cadence TCDs are built too. The DWT cycle counter
+*               is started to time the refills.
 *
 * Return value: None
 *
@@ -45,41 +224,364 @@ void DMAInit(void){
     SIM_SCGC7 |= SIM_SCGC7_DMA_MASK;
 
     DMAMUX_CHCFG(0) |= (DMAMUX_CHCFG_ENBL(0)|DMAMUX_CHCFG_TRIG(0));
-    DMA_SADDR(0) = DMA_SADDR_SADDR(dmaWaveTable);
-    DMA_ATTR(0) = (DMA_ATTR_SSIZE(001) | DMA_ATTR_SMOD(0) | DMA_ATTR_DMOD(0) | DMA_ATTR_DSIZE(001));
-    DMA_SOFF(0) = 2;
-    DMA_SLAST(0) = DMA_SLAST_SLAST(-128);
-    DMA_DADDR(0) = DMA_DADDR_DADDR(&DAC0_DAT0L);
-    DMA_DOFF(0) = DMA_DOFF_DOFF(0);
-    DMA_TCD0_NBYTES_MLNO = DMA_NBYTES_MLNO_NBYTES(2);
-    DMA_CITER_ELINKNO(0) = DMA_CITER_ELINKNO_CITER(64);
-    DMA_BITER_ELINKNO(0) = DMA_BITER_ELINKNO_BITER(64);
-    DMA_TCD0_CSR = 0x5300u;
-    DMA_DLAST_SGA(0) = DMA_DLAST_SGA_DLASTSGA(0);
-    DMAMUX_CHCFG(0) = DMAMUX_CHCFG_ENBL(1)|DMAMUX_CHCFG_TRIG(1)|DMAMUX_CHCFG_SOURCE(60);
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    dmaFill(&dmaBuffer[0]);
+    dmaGainHalf(&dmaBuffer[0]);
+    dmaFill(&dmaBuffer[DMA_HALF_SAMPLES]);
+    dmaGainHalf(&dmaBuffer[DMA_HALF_SAMPLES]);
+    dmaScaleTones();
+    dmaSetTCD(&dmaPingTCD[0], &dmaBuffer[0], 2, 0, DMA_HALF_SAMPLES, &dmaPingTCD[1],
+              (DMA_CSR_ESG(1)|DMA_CSR_INTMAJOR(1)));
+    dmaSetTCD(&dmaPingTCD[1], &dmaBuffer[DMA_HALF_SAMPLES], 2, 0, DMA_HALF_SAMPLES, &dmaPingTCD[0],
+              (DMA_CSR_ESG(1)|DMA_CSR_INTMAJOR(1)));
+    dmaBuildCadences();
+    DMA_SADDR(0) = DMA_SADDR_SADDR(dmaPingTCD[0].saddr);
+    DMA_ATTR(0) = dmaPingTCD[0].attr;
+    DMA_SOFF(0) = dmaPingTCD[0].soff;
+    DMA_SLAST(0) = DMA_SLAST_SLAST(dmaPingTCD[0].slast);
+    DMA_DADDR(0) = DMA_DADDR_DADDR(dmaPingTCD[0].daddr);
+    DMA_DOFF(0) = dmaPingTCD[0].doff;
+    DMA_TCD0_NBYTES_MLNO = dmaPingTCD[0].nbytes;
+    DMA_CITER_ELINKNO(0) = dmaPingTCD[0].citer;
+    DMA_BITER_ELINKNO(0) = dmaPingTCD[0].biter;
+    DMA_DLAST_SGA(0) = DMA_DLAST_SGA_DLASTSGA(dmaPingTCD[0].dlast_sga);
+    DMA_TCD0_CSR = dmaPingTCD[0].csr;
+    DMAMUX_CHCFG(0) = DMAMUX_CHCFG_ENBL(1)|DMAMUX_CHCFG_TRIG(DMA_MUX_TRIG)|DMAMUX_CHCFG_SOURCE(DMA_MUX_SOURCE);
+    NVIC_ClearPendingIRQ(DMA0_DMA16_IRQn);
+    NVIC_EnableIRQ(DMA0_DMA16_IRQn);
     DMA_SERQ = DMA_SERQ_SERQ(0);
 
 }
 /********************************************************************
+* DMASetSound - Selects the alarm sound
+*
+* Description:  Taken up at the next refill, the phase carries on so the
+*               change has no glitch.
+*
+* Return value: None
+*
+* Arguments:    DMA_SOUND_TONE, DMA_SOUND_SIREN or DMA_SOUND_PULSE
+********************************************************************/
+void DMASetSound(DMA_SOUND sound){
+    dmaSound = sound;
+}
+/********************************************************************
+* DMAPlayClip - Plays an ADPCM clip once
+*
+* Description:  Starts at the next refill and replaces the sound until the
+*               clip ends. The clip rate can be up to DMA_FS_HZ.
+*
+* Return value: None
+*
+* Arguments:    Clip in flash
+********************************************************************/
+void DMAPlayClip(const ADPCM_CLIP *clip){
+    dmaClipNext = clip;
+}
+/********************************************************************
+* DMAPlayCadence - Plays a tone cadence entirely in the DMA
+*
+* Description:  Links the live TCD to the head of the cadence, so it starts
+*               at the end of the current half or step and then loops with
+*               no interrupts.
+*
+* Return value: None
+*
+* Arguments:    The cadence
+********************************************************************/
+void DMAPlayCadence(DMA_CADENCE cadence){
+    dmaCadenceStop = 0;
+    dmaCadenceOn = 1;
+    DMA_DLAST_SGA(0) = DMA_DLAST_SGA_DLASTSGA((INT32U)dmaCadenceHead[cadence]);
+}
+/********************************************************************
+* DMAStopCadence - Goes back to the ping-pong buffer
+*
+* Description:  Does nothing unless a cadence is playing. If the live step
+*               is silence or a decay, the live TCD is linked to the first
+*               half's TCD now. Otherwise DMA0_DMA16_IRQHandler does it at
+*               the end of the sustain, when the decay is loaded, so a
+*               tone always ends through its decay.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void DMAStopCadence(void){
+    INT32U saddr;
+
+    if(dmaCadenceOn != 0){
+        NVIC_DisableIRQ(DMA0_DMA16_IRQn);
+        saddr = DMA_SADDR(0);
+        if((saddr == (INT32U)&dmaSilence) ||
+           ((saddr >= (INT32U)&dmaToneADown[0]) && (saddr < (INT32U)&dmaToneADown[DMA_ENV_SAMPLES])) ||
+           ((saddr >= (INT32U)&dmaToneBDown[0]) && (saddr < (INT32U)&dmaToneBDown[DMA_ENV_SAMPLES]))){
+            dmaEndCadence();
+        } else{
+            dmaCadenceStop = 1;
+        }
+        NVIC_EnableIRQ(DMA0_DMA16_IRQn);
+    } else{
+    }
+}
+/********************************************************************
+* DMAAlarmOn - Starts the alarm sound
+*
+* Description:  Starts the sample clock, the sound ramps up over
+*               DMA_RAMP_HALVES.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void DMAAlarmOn(void){
+    dmaAlarmOn = 1;
+    dmaClockOn();
+}
+/********************************************************************
+* DMAAlarmOff - Stops the alarm sound
+*
+* Description:  The sound ramps down and the first refill after both halves
+*               are silent stops the sample clock. A cadence has no refills, so it is stopped first and
+*               ends with its current step.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void DMAAlarmOff(void){
+    dmaAlarmOn = 0;
+    DMAStopCadence();
+}
+/********************************************************************
+* DMASetVolume - Sets the alarm volume
+*
+* Description:  Ramped to at the next refills. The cadence tables and
+*               their attack and decay are rescaled here, a cadence playing
+*               takes the new level within one period.
+*
+* Return value: None
+*
+* Arguments:    0-100 percent
+********************************************************************/
+void DMASetVolume(INT8U percent){
+    if(percent > 100){
+        percent = 100;
+    } else{
+    }
+    dmaVolume = ((INT32S)percent*DMA_GAIN_ONE)/100;
+    dmaScaleTones();
+}
+/********************************************************************
+* DMARefillCycles - Returns the longest refill so far
+*
+* Description:  Measured with the DWT cycle counter from the start to the
+*               end of DMA0_DMA16_IRQHandler, sound, clip and gain stage.
+*
+* Return value: Core clocks, at 180MHz
+*
+* Arguments:    None
+********************************************************************/
+INT32U DMARefillCycles(void){
+    return(dmaRefillCycles);
+}
+/********************************************************************
+* DMA0_DMA16_IRQHandler - DMA channel 0 half or major loop complete
+*
+* Description:  Runs at the end of each half's TCD, when the next TCD has
+*               already been loaded, so the live source address shows which
+*               half is being read. The other half is refilled, which has a
+*               half of samples, 3.3ms, to finish. While a cadence plays
+*               the halves are not in use; the last half before it and the
+*               end of each sustain land here only to leave the cadence
+*               when asked.
+*               The clock is stopped once the alarm is off and the gain was
+*               0 at the end of both of the last two refills, so the half
+*               about to play is silent and the one just played ended at
+*               mid scale. Deciding before this refill's ramp keeps the
+*               clock from stopping on a half still ramping down.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void DMA0_DMA16_IRQHandler(void){
+    INT32U start = DWT->CYCCNT;
+    INT32U cycles;
+    INT16U *half;
+    INT8U stop = (INT8U)((dmaAlarmOn == 0) && (dmaGain == 0) && (dmaGainPrev == 0));
+
+    DMA_CINT = DMA_CINT_CINT(0);
+    if(dmaCadenceOn != 0){
+        if(dmaCadenceStop != 0){
+            dmaEndCadence();                    //The decay is live now
+        } else{
+        }
+        return;
+    } else{
+    }
+    dmaNextHalf();
+    if((DMA_SADDR(0) >= (INT32U)&dmaBuffer[0]) && (DMA_SADDR(0) < (INT32U)&dmaBuffer[DMA_HALF_SAMPLES])){
+        half = &dmaBuffer[DMA_HALF_SAMPLES];
+    } else{
+        half = &dmaBuffer[0];
+    }
+    dmaFill(half);
+    dmaGainHalf(half);
+    if(stop != 0){
+        dmaClockOff();                          //Both halves silent now
+    } else{
+    }
+    cycles = DWT->CYCCNT - start;
+    if(cycles > dmaRefillCycles){
+        dmaRefillCycles = cycles;
+    } else{
+    }
+}
+/********************************************************************
+* dmaNextHalf - Steps the sound pattern once per half
+*
+* Description:  A new sound starts its pattern from the beginning. The
+*               siren sweeps the phase increment between DMA_SIREN_LOW_HZ
+*               and DMA_SIREN_HIGH_HZ, the pulse gates the tone.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+static void dmaNextHalf(void){
+    if(dmaClipNext != 0){
+        dmaClip = dmaClipNext;
+        dmaClipNext = 0;
+        dmaClipState = dmaClip->start;
+        dmaClipPrev = dmaClip->start.predictor;
+        dmaClipCur = dmaClip->start.predictor;
+        dmaClipPos = 0;
+        dmaClipFrac = 0;
+        dmaClipStep = (INT32U)(((INT64U)dmaClip->rate_hz << DMA_CLIP_FRAC_BITS)/DMA_FS_HZ);
+    } else{
+    }
+    if(dmaSoundNow != dmaSound){
+        dmaSoundNow = dmaSound;
+        dmaHalfCount = 0;
+        dmaRising = 1;
+        if(dmaSoundNow == DMA_SOUND_SIREN){
+            dmaPhaseInc = DMA_PHASE_INC(DMA_SIREN_LOW_HZ);
+        } else{
+            dmaPhaseInc = DMA_PHASE_INC(DMA_TONE_HZ);
+        }
+    } else{
+    }
+    switch(dmaSoundNow){
+        case(DMA_SOUND_SIREN):
+            if(dmaRising != 0){
+                dmaPhaseInc += DMA_SIREN_STEP;
+            } else{
+                dmaPhaseInc -= DMA_SIREN_STEP;
+            }
+            dmaHalfCount++;
+            if(dmaHalfCount >= DMA_SIREN_HALVES){
+                dmaHalfCount = 0;
+                dmaRising = (INT8U)(dmaRising == 0);
+            } else{
+            }
+            break;
+        case(DMA_SOUND_PULSE):
+            dmaHalfCount++;
+            if(dmaHalfCount >= (2*DMA_PULSE_HALVES)){
+                dmaHalfCount = 0;
+            } else{
+            }
+            break;
+        default:
+            break;
+    }
+}
+/********************************************************************
+* dmaFill - Fills one half of dmaBuffer
+*
+* Description:  The top DMA_TABLE_BITS of the phase index dmaWaveTable and
+*               the next DMA_FRAC_BITS interpolate to the following entry.
+*               The off part of a pulse is mid scale.
+*
+* Return value: None
+*
+* Arguments:    First sample of the half
+********************************************************************/
+static void dmaFill(INT16U *half){
+    INT32S a;
+    INT32S b;
+    INT32U frac;
+    INT32U index;
+    INT16U i;
+
+    if(dmaClip != 0){
+        dmaFillClip(half);
+    } else if((dmaSoundNow == DMA_SOUND_PULSE) && (dmaHalfCount >= DMA_PULSE_HALVES)){
+        for(i = 0; i < DMA_HALF_SAMPLES; i++){
+            half[i] = DMA_SILENCE;
+        }
+    } else{
+        for(i = 0; i < DMA_HALF_SAMPLES; i++){
+            index = dmaPhase >> (32 - DMA_TABLE_BITS);
+            frac = (dmaPhase >> (32 - DMA_TABLE_BITS - DMA_FRAC_BITS)) & ((1uL << DMA_FRAC_BITS) - 1);
+            a = dmaWaveTable[index];
+            b = dmaWaveTable[(index + 1) & ((1uL << DMA_TABLE_BITS) - 1)];
+            half[i] = (INT16U)(a + (((b - a)*(INT32S)frac) >> DMA_FRAC_BITS));
+            dmaPhase += dmaPhaseInc;
+        }
+    }
+}
+/********************************************************************
 * DMADAC0Init - Initializes DAC0
 *
 * Description:  Enables DAC system, software trigger, and VDDA reference. Also
-*               enables DMA and DAC buffer.
+*               enables DMA and DAC buffer. With DMA_DAC_BUF_EN the trigger is
+*               the hardware one from PDB0 instead, all 16 words are used in
+*               normal mode with the watermark 4 words from the top, and
+*               the watermark and top flags request DMA. The top flag is set
+*               out of reset with the pointer at 0, so the first burst goes
+*               to words 8-15, then the watermark at word 11 fills 0-7 and
+*               the pointer wrapping to 0 fills 8-15 again. PDB0 runs
+*               continuously with its DAC interval trigger every
+*               PIT0_TIMER_VALUE + 1 bus clocks, the modulus a whole number
+*               of intervals so the spacing never changes. PDB0 is left
+*               disabled, dmaClockOn() starts it.
 *
 * Return value: None
 *
 * Arguments:    None
 ********************************************************************/
 void DMADAC0Init(void){
+#if DMA_DAC_BUF_EN
+    INT8U i;
+
+    SIM_SCGC2 = (SIM_SCGC2 | SIM_SCGC2_DAC0(1));
+    for(i = 0; i < DMA_DAC_WORDS; i++){
+        DAC_DATL_REG(DAC0, i) = (INT8U)DMA_SILENCE;
+        DAC_DATH_REG(DAC0, i) = (INT8U)(DMA_SILENCE >> 8);
+    }
+    DAC0_C2 = DAC_C2_DACBFUP(DMA_DAC_WORDS - 1);
+    DAC0_C0 |= DAC_C0_DACEN(1) | DAC_C0_DACRFS(1) | DAC_C0_DACTRGSEL(0) |
+               DAC_C0_DACBWIEN(1) | DAC_C0_DACBTIEN(1);
+    DAC0_C1 |= (DAC_C1_DMAEN(1) | DAC_C1_DACBFEN(1) | DAC_C1_DACBFMD(0) | DAC_C1_DACBFWM(3));
+    SIM_SCGC6 |= SIM_SCGC6_PDB(1);
+    PDB0_SC = (PDB_SC_CONT(1) | PDB_SC_TRGSEL(15) | PDB_SC_PRESCALER(0));
+    PDB0_DACINTC0 = PDB_INTC_TOE(1);
+#else
     SIM_SCGC2 = (SIM_SCGC2 | SIM_SCGC2_DAC0(1));
     DAC0_C0 |= DAC_C0_DACEN(1) | DAC_C0_DACRFS(1) | DAC_C0_DACTRGSEL(1);
     DAC0_C1 |= (DAC_C1_DMAEN(1) | DAC_C1_DACBFEN(1));
+#endif
 }
 /********************************************************************
 * DMAPIT0Init - Initializes PIT0
 *
 * Description:  Enables PIT clock 0. Enables all standard timers. Enables
 *               PIT0 timer and PIT0 timer interrupt. Triggers at 300Hz.
+*               With DMA_DAC_BUF_EN PDB0 clocks the DAC and PIT0 is left
+*               stopped, with no interrupt.
 *
 * Return value: None
 *
@@ -88,9 +590,296 @@ void DMADAC0Init(void){
 void DMAPIT0Init(void){
     SIM_SCGC6 = (SIM_SCGC6 | SIM_SCGC6_PIT(1));
     PIT_MCR = PIT_MCR_MDIS(0);
+#if (DMA_DAC_BUF_EN == 0)
     PIT_TCTRL0 = (PIT_TCTRL0 | PIT_TCTRL_TIE(1) | PIT_TCTRL_TEN(1));
+#endif
     PIT_LDVAL0 = PIT0_TIMER_VALUE;
 }
+/********************************************************************
+* dmaFillClip - Fills one half of dmaBuffer from the playing clip
+*
+* Description:  The clip is resampled to DMA_FS_HZ by linear interpolation
+*               between the last two decoded samples, a new code is decoded
+*               each time the position passes a clip sample. At 9.6kHz that
+*               is 32 codes a half. After the last code the rest of the half
+*               is mid scale and the sound carries on at the next half.
+*
+* Return value: None
+*
+* Arguments:    First sample of the half
+********************************************************************/
+static void dmaFillClip(INT16U *half){
+    INT32S pcm;
+    INT8U code;
+    INT16U i;
 
+    for(i = 0; i < DMA_HALF_SAMPLES; i++){
+        if(dmaClip != 0){
+            pcm = dmaClipPrev + ((((INT32S)dmaClipCur - dmaClipPrev)*(INT32S)(dmaClipFrac >> 1)) >>
+                                 (DMA_CLIP_FRAC_BITS - 1));
+            half[i] = (INT16U)((pcm >> DMA_PCM_SHIFT) + DMA_SILENCE);
+            dmaClipFrac += dmaClipStep;
+            while((dmaClipFrac >= (1uL << DMA_CLIP_FRAC_BITS)) && (dmaClip != 0)){
+                dmaClipFrac -= (1uL << DMA_CLIP_FRAC_BITS);
+                if(dmaClipPos < dmaClip->samples){
+                    code = dmaClip->data[dmaClipPos >> 1];
+                    if((dmaClipPos & 1u) != 0){
+                        code >>= 4;
+                    } else{
+                    }
+                    dmaClipPrev = dmaClipCur;
+                    dmaClipCur = ADPCMDecode(&dmaClipState, (INT8U)(code & 0xFu));
+                    dmaClipPos++;
+                } else{
+                    dmaClip = 0;
+                }
+            }
+        } else{
+            half[i] = DMA_SILENCE;
+        }
+    }
+}
+/********************************************************************
+* dmaSetTCD - Fills a RAM TCD that feeds DAC0
+*
+* Return value: None
+*
+* Arguments:    TCD, source, source offset, source modulo, samples, TCD
+*               to load next, CSR
+********************************************************************/
+static void dmaSetTCD(DMA_TCD *tcd, const void *src, INT16S soff, INT8U smod, INT16U citer,
+                      const DMA_TCD *next, INT16U csr){
+    tcd->saddr = (INT32U)src;
+    tcd->soff = soff;
+    tcd->attr = (DMA_ATTR_SSIZE(001) | DMA_ATTR_SMOD(smod) | DMA_ATTR_DMOD(DMA_DAC_DMOD) | DMA_ATTR_DSIZE(001));
+    tcd->nbytes = DMA_NBYTES_MLNO_NBYTES(2*DMA_BURST);
+    tcd->slast = 0;
+    tcd->daddr = (INT32U)DMA_DAC_DADDR;
+    tcd->doff = DMA_DAC_DOFF;
+    tcd->citer = DMA_CITER_ELINKNO_CITER(citer/DMA_BURST);
+    tcd->dlast_sga = (INT32U)next;
+    tcd->csr = csr;
+    tcd->biter = DMA_BITER_ELINKNO_BITER(citer/DMA_BURST);
+}
+/********************************************************************
+* dmaBuildCadences - Builds the TCD chain of each pattern
+*
+* Description:  One TCD a silent step and three a tone step, the last
+*               linking back to the first. Step lengths are whole table
+*               periods or bursts. A tone step is dmaSetTone(). Silence
+*               reads dmaSilence with no offset.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+static void dmaBuildCadences(void){
+    const DMA_PATTERN *pattern;
+    const DMA_STEP *step;
+    DMA_TCD *tcd = &dmaCadenceTCD[0];
+    INT32U samples;
+    INT8U p;
+    INT8U i;
 
+    for(p = 0; p < (sizeof(dmaPatterns)/sizeof(dmaPatterns[0])); p++){
+        pattern = &dmaPatterns[p];
+        dmaCadenceHead[p] = tcd;
+        for(i = 0; i < pattern->num_steps; i++){
+            step = &pattern->steps[i];
+            samples = ((INT32U)step->ms*DMA_FS_HZ)/1000;
+            switch(step->tone){
+                case(DMA_TONE_A):
+                    samples &= ~(DMA_WAVE_N - 1u);
+                    tcd = dmaSetTone(tcd, dmaToneARam, dmaToneAUp, dmaToneADown, DMA_TABLE_BITS + 1, samples);
+                    break;
+                case(DMA_TONE_B):
+                    samples &= ~((1u << DMA_TONE_B_BITS) - 1u);
+                    tcd = dmaSetTone(tcd, dmaToneBRam, dmaToneBUp, dmaToneBDown, DMA_TONE_B_BITS + 1, samples);
+                    break;
+                default:
+                    samples &= ~(DMA_BURST - 1u);
+                    dmaSetTCD(tcd, &dmaSilence, 0, 0, (INT16U)samples, tcd + 1, DMA_CSR_ESG(1));
+                    tcd++;
+                    break;
+            }
+        }
+        (tcd - 1)->dlast_sga = (INT32U)dmaCadenceHead[p];
+    }
+}
+/********************************************************************
+* dmaSetTone - Builds the attack, sustain and decay TCDs of a tone step
+*
+* Description:  The sustain reads its table with SMOD wrapping at the table
+*               size for a whole number of periods, so it ends where it
+*               started, and interrupts at its end so a cadence can be left
+*               through the decay. Steps are at least 150ms, far more than
+*               the 2*DMA_ENV_SAMPLES the ramps take.
+*
+* Return value: The TCD after the three
+*
+* Arguments:    First TCD, sustain table, attack, decay, sustain SMOD,
+*               step length in samples
+********************************************************************/
+static DMA_TCD *dmaSetTone(DMA_TCD *tcd, const INT16U *sustain, const INT16U *up, const INT16U *down,
+                           INT8U smod, INT32U samples){
+    dmaSetTCD(tcd, up, 2, 0, DMA_ENV_SAMPLES, tcd + 1, DMA_CSR_ESG(1));
+    dmaSetTCD(tcd + 1, sustain, 2, smod, (INT16U)(samples - (2*DMA_ENV_SAMPLES)), tcd + 2,
+              (DMA_CSR_ESG(1)|DMA_CSR_INTMAJOR(1)));
+    dmaSetTCD(tcd + 2, down, 2, 0, DMA_ENV_SAMPLES, tcd + 3, DMA_CSR_ESG(1));
+    return(tcd + 3);
+}
+/********************************************************************
+* dmaScaleTones - Makes the cadence tables at the volume
+*
+* Description:  The sustain tables are one period at the volume. The
+*               attack and decay are DMA_ENV_SAMPLES of whole periods with
+*               the gain moving linearly between 0 and the volume.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+static void dmaScaleTones(void){
+    INT32S step = dmaVolume/(DMA_ENV_SAMPLES/2);
+    INT16U i;
+
+    dmaScale(dmaToneARam, dmaWaveTable, DMA_WAVE_N, dmaVolume, 0);
+    dmaScale(dmaToneBRam, dmaToneBTable, (1u << DMA_TONE_B_BITS), dmaVolume, 0);
+    for(i = 0; i < DMA_ENV_SAMPLES; i += DMA_WAVE_N){
+        dmaScale(&dmaToneAUp[i], dmaWaveTable, DMA_WAVE_N, step*(i/2), step);
+        dmaScale(&dmaToneADown[i], dmaWaveTable, DMA_WAVE_N, dmaVolume - (step*(i/2)), -step);
+    }
+    for(i = 0; i < DMA_ENV_SAMPLES; i += (1u << DMA_TONE_B_BITS)){
+        dmaScale(&dmaToneBUp[i], dmaToneBTable, (1u << DMA_TONE_B_BITS), step*(i/2), step);
+        dmaScale(&dmaToneBDown[i], dmaToneBTable, (1u << DMA_TONE_B_BITS), dmaVolume - (step*(i/2)), -step);
+    }
+}
+/********************************************************************
+* dmaEndCadence - Links the live TCD back to the first half's TCD
+*
+* Description:  Only called with a silent step or a decay live. The halves
+*               were not in use, so they are set to silence and the gain
+*               ramps up from 0 from the first refill on.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+static void dmaEndCadence(void){
+    INT16U i;
+
+    for(i = 0; i < (2*DMA_HALF_SAMPLES); i++){
+        dmaBuffer[i] = DMA_SILENCE;
+    }
+    dmaGain = 0;
+    dmaGainPrev = 0;
+    dmaCadenceStop = 0;
+    dmaCadenceOn = 0;
+    DMA_DLAST_SGA(0) = DMA_DLAST_SGA_DLASTSGA((INT32U)&dmaPingTCD[0]);
+}
+/********************************************************************
+* dmaGainHalf - Applies the volume and on/off envelope to one half
+*
+* Description:  The gain moves from where the last half ended toward the
+*               volume, or 0 when off, by at most 1/DMA_RAMP_HALVES of full
+*               scale, in equal steps across the half.
+*
+* Return value: None
+*
+* Arguments:    First sample of the half
+********************************************************************/
+static void dmaGainHalf(INT16U *half){
+    INT32S target = 0;
+    INT32S delta;
 
+    if(dmaAlarmOn != 0){
+        target = dmaVolume;
+    } else{
+    }
+    delta = target - dmaGain;
+    if(delta > (DMA_GAIN_ONE/DMA_RAMP_HALVES)){
+        delta = DMA_GAIN_ONE/DMA_RAMP_HALVES;
+    } else if(delta < -(DMA_GAIN_ONE/DMA_RAMP_HALVES)){
+        delta = -(DMA_GAIN_ONE/DMA_RAMP_HALVES);
+    } else{
+    }
+    dmaScale(half, half, DMA_HALF_SAMPLES, dmaGain, delta/(DMA_HALF_SAMPLES/2));
+    dmaGainPrev = dmaGain;
+    dmaGain += delta;
+}
+/********************************************************************
+* dmaScale - Scales DAC samples about mid scale, two at a time
+*
+* Description:  Each word holds two samples. __SSUB16 takes mid scale off
+*               both, SMULWB/SMULWT multiply each by the Q16 gain keeping the
+*               top 16 bits, __PKHBT packs them back, __SSAT16 saturates
+*               both to the DAC width and __SADD16 puts mid scale back. The
+*               gain moves by step after each pair.
+*
+* Return value: None
+*
+* Arguments:    Destination, source (may be the same), even number of
+*               samples, Q16 gain, Q16 gain step per pair
+********************************************************************/
+static void dmaScale(INT16U *dst, const INT16U *src, INT16U samples, INT32S gain, INT32S step){
+    INT32U *out = (INT32U *)dst;
+    const INT32U *in = (const INT32U *)src;
+    INT32U pair;
+    INT16U i;
+
+    for(i = 0; i < (samples/2); i++){
+        pair = __SSUB16(in[i], DMA_SILENCE_PAIR);
+        pair = __PKHBT(dmaSMULWB(gain, pair), dmaSMULWT(gain, pair), 16);
+        out[i] = __SADD16(__SSAT16(pair, DMA_DAC_BITS), DMA_SILENCE_PAIR);
+        gain += step;
+    }
+}
+/********************************************************************
+* dmaSMULWB/dmaSMULWT - 32x16 signed multiply, top 32 of 48 bits
+*
+* Description:  (gain*bottom or top lane) >> 16 in one instruction. Not in
+*               this core_cm4_simd.h, so wrapped here the same way.
+********************************************************************/
+static INT32S dmaSMULWB(INT32S gain, INT32U pair){
+    INT32S result;
+
+    __ASM volatile ("smulwb %0, %1, %2" : "=r" (result) : "r" (gain), "r" (pair));
+    return(result);
+}
+static INT32S dmaSMULWT(INT32S gain, INT32U pair){
+    INT32S result;
+
+    __ASM volatile ("smulwt %0, %1, %2" : "=r" (result) : "r" (gain), "r" (pair));
+    return(result);
+}
+/********************************************************************
+* dmaClockOn/dmaClockOff - Starts/stops the DAC sample clock
+*
+* Description:  PIT0 gating the DMA requests, or PDB0 triggering the DAC
+*               with DMA_DAC_BUF_EN, where stopping PDB0 also stops the
+*               buffer flags and so the requests. PDB0 is only started
+*               when stopped, a SWTRIG while running restarts its count.
+*               LDOK is ignored while PDBEN is clear, so the modulus and
+*               DAC interval are written and loaded after enabling it.
+********************************************************************/
+static void dmaClockOn(void){
+#if DMA_DAC_BUF_EN
+    if((PDB0_SC & PDB_SC_PDBEN_MASK) == 0){
+        PDB0_SC |= PDB_SC_PDBEN(1);
+        PDB0_MOD = DMA_PDB_MOD;
+        PDB0_DACINT0 = PIT0_TIMER_VALUE;
+        PDB0_SC |= PDB_SC_LDOK(1);
+        PDB0_SC |= PDB_SC_SWTRIG(1);
+    } else{
+    }
+#else
+    PIT_TCTRL0 |= PIT_TCTRL_TEN(1);
+#endif
+}
+static void dmaClockOff(void){
+#if DMA_DAC_BUF_EN
+    PDB0_SC &= ~PDB_SC_PDBEN_MASK;
+#else
+    PIT_TCTRL0 &= ~PIT_TCTRL_TEN_MASK;
+#endif
+}
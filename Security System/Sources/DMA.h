@@ -7,13 +7,19 @@
 #ifndef SOURCES_DMA_H_
 #define SOURCES_DMA_H_
 
-#define PIT0_TIMER_VALUE 3124
+#define DMA_FS_HZ 19200                 //DAC sample rate
+#define PIT0_TIMER_VALUE 3124           //60MHz/DMA_FS_HZ - 1, checked in DMA.c
+#define DMA_TONE_HZ 300                 //DMA_SOUND_TONE fundamental
+#define DMA_DAC_BUF_EN 1                //0 sends one sample per PIT0 trigger
+
+typedef enum{DMA_SOUND_TONE, DMA_SOUND_SIREN, DMA_SOUND_PULSE} DMA_SOUND;
+typedef enum{DMA_CADENCE_TEMPORAL3, DMA_CADENCE_HI_LO, DMA_CADENCE_TRIPLE} DMA_CADENCE;
 
 /********************************************************************
 * DMAInit - Initializes DMA0
 *
-* Description:  Enables DMA for use with transferring data in dmaWaveTable to
-*               DAC0. Uses PIT0 for triggering.
+* Description:  Enables DMA for use with transferring the ping-pong audio
+*               buffer to DAC0. Uses PIT0 for triggering.
 *
 * Return value: None
 *
@@ -24,7 +30,9 @@ void DMAInit(void);
 * DMADAC0Init - Initializes DAC0
 *
 * Description:  Enables both DAC0 clocks. Enables DAC system, software trigger,
-*               and VDDA reference. Also enables DMA and DAC buffer.
+*               and VDDA reference. Also enables DMA and DAC buffer. With
+*               DMA_DAC_BUF_EN, PDB0 triggers the DAC at DMA_FS_HZ and the
+*               DAC buffer watermark requests DMA bursts.
 *
 * Return value: None
 *
@@ -42,5 +50,96 @@ void DMADAC0Init(void);
 * Arguments:    None
 ********************************************************************/
 void DMAPIT0Init(void);
+/********************************************************************
+* DMASetSound - Selects the alarm sound
+*
+* Description:  The tone is the steady 300Hz wave, the siren sweeps it
+*               300-900Hz and back each second, the pulse turns the tone on
+*               and off every 200ms. Takes effect within one refill.
+*
+* Return value: None
+*
+* Arguments:    DMA_SOUND_TONE, DMA_SOUND_SIREN or DMA_SOUND_PULSE
+********************************************************************/
+void DMASetSound(DMA_SOUND sound);
+/********************************************************************
+* DMAPlayClip - Plays an ADPCM clip once
+*
+* Description:  Decoded a half at a time in the DMA interrupt, in place of
+*               the sound until the clip ends.
+*
+* Return value: None
+*
+* Arguments:    Clip in flash, see ADPCM.h
+********************************************************************/
+void DMAPlayClip(const ADPCM_CLIP *clip);
+/********************************************************************
+* DMAPlayCadence - Plays a tone cadence entirely in the DMA
+*
+* Description:  The cadence is a scatter/gather chain of prebuilt TCDs that
+*               loops with no CPU. Temporal-3 is three 0.5s beeps and 1.5s
+*               off, hi-lo alternates 300Hz and 600Hz, triple is three short
+*               300Hz beeps and a long 600Hz one. Starts within one step.
+*               Every beep ramps up and down over 13ms, no clicks.
+*
+* Return value: None
+*
+* Arguments:    The cadence
+********************************************************************/
+void DMAPlayCadence(DMA_CADENCE cadence);
+/********************************************************************
+* DMAStopCadence - Goes back to the sound and clips of DMASetSound() and
+*                  DMAPlayClip()
+*
+* Description:  A tone playing finishes its 13ms decay first.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void DMAStopCadence(void);
+/********************************************************************
+* DMAAlarmOn - Starts the alarm sound
+*
+* Description:  Ramps up from silence, no click. Can be called repeatedly.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void DMAAlarmOn(void);
+/********************************************************************
+* DMAAlarmOff - Stops the alarm sound
+*
+* Description:  Ramps down to silence, then PIT0 is stopped. Can be called
+*               repeatedly.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void DMAAlarmOff(void);
+/********************************************************************
+* DMASetVolume - Sets the alarm volume
+*
+* Return value: None
+*
+* Arguments:    0-100 percent, 100 is the full wavetable level
+********************************************************************/
+void DMASetVolume(INT8U percent);
+/********************************************************************
+* DMARefillCycles - Returns the longest buffer refill so far
+*
+* Return value: Core clocks
+*
+* Arguments:    None
+********************************************************************/
+INT32U DMARefillCycles(void);
+/********************************************************************
+* DMA0_DMA16_IRQHandler - DMA channel 0 half or major loop complete
+*
+* Handler must be public for linker to see it.
+********************************************************************/
+void DMA0_DMA16_IRQHandler(void);
 
 #endif /* SOURCES_DMA_H_ */
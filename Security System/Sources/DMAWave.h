@@ -0,0 +1,56 @@
+/*******************************************************************************
+* DMAWave.h - Compile-time wavetable generator for DAC tones
+*
+* Description: DMA_WAVE_TABLE(n, bits, a1, a2, a3, a4, a5) expands to the
+*              initializer of one period of a1*sin(x) + a2*sin(2x) + ... +
+*              a5*sin(5x) in n samples, scaled by the sum of the amplitudes
+*              so it can never clip, centered on the DAC mid scale for a
+*              bits wide DAC and rounded. The amplitudes are relative, 0
+*              leaves a harmonic out. n is 16, 32, 64, 128 or 256.
+*              Everything is an arithmetic constant expression, so the
+*              compiler puts only the finished table in flash. sin() is a
+*              9th order Taylor polynomial on [0, pi/2], under 4e-6 off,
+*              after folding the integer phase (k*i) % n into that range.
+*              Whether the harmonics stay under Nyquist at the frequencies
+*              the table is played at is checked where it is used.
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#ifndef SOURCES_DMAWAVE_H_
+#define SOURCES_DMAWAVE_H_
+
+#define DMA_WAVE_HARMONICS 5
+#define DMA_WAVE_PI 3.14159265358979
+
+/* Phase (k*i) % n folded to a quarter wave, and the sign of that half */
+#define DMA_WAVE_PH(i, k, n) (((k)*(i)) % (n))
+#define DMA_WAVE_HALF(i, k, n) ((DMA_WAVE_PH(i, k, n) < ((n)/2)) ? DMA_WAVE_PH(i, k, n) : (DMA_WAVE_PH(i, k, n) - ((n)/2)))
+#define DMA_WAVE_SIGN(i, k, n) ((DMA_WAVE_PH(i, k, n) < ((n)/2)) ? 1.0 : -1.0)
+#define DMA_WAVE_QTR(i, k, n) (((2*DMA_WAVE_HALF(i, k, n)) > ((n)/2)) ? (((n)/2) - DMA_WAVE_HALF(i, k, n)) : DMA_WAVE_HALF(i, k, n))
+#define DMA_WAVE_X(i, k, n) ((2.0*DMA_WAVE_PI*DMA_WAVE_QTR(i, k, n))/(n))
+
+/* sin(x) for 0 <= x <= pi/2 */
+#define DMA_WAVE_POLY(x) ((x)*(1.0 - (((x)*(x))/6.0)*(1.0 - (((x)*(x))/20.0)*(1.0 - (((x)*(x))/42.0)* \
+                         (1.0 - (((x)*(x))/72.0))))))
+#define DMA_WAVE_SIN(i, k, n) (DMA_WAVE_SIGN(i, k, n)*DMA_WAVE_POLY(DMA_WAVE_X(i, k, n)))
+
+#define DMA_WAVE_MID(bits) (1uL << ((bits) - 1))
+#define DMA_WAVE_SAMPLE(i, n, bits, a1, a2, a3, a4, a5) \
+    ((INT16U)(DMA_WAVE_MID(bits) + 0.5 + (((DMA_WAVE_MID(bits) - 1.0)* \
+        (((a1)*DMA_WAVE_SIN(i, 1, n)) + ((a2)*DMA_WAVE_SIN(i, 2, n)) + ((a3)*DMA_WAVE_SIN(i, 3, n)) + \
+         ((a4)*DMA_WAVE_SIN(i, 4, n)) + ((a5)*DMA_WAVE_SIN(i, 5, n))))/((a1) + (a2) + (a3) + (a4) + (a5)))))
+
+#define DMA_WAVE_R1(i, ...) DMA_WAVE_SAMPLE(i, __VA_ARGS__),
+#define DMA_WAVE_R2(i, ...) DMA_WAVE_R1(i, __VA_ARGS__) DMA_WAVE_R1((i) + 1, __VA_ARGS__)
+#define DMA_WAVE_R4(i, ...) DMA_WAVE_R2(i, __VA_ARGS__) DMA_WAVE_R2((i) + 2, __VA_ARGS__)
+#define DMA_WAVE_R8(i, ...) DMA_WAVE_R4(i, __VA_ARGS__) DMA_WAVE_R4((i) + 4, __VA_ARGS__)
+#define DMA_WAVE_R16(i, ...) DMA_WAVE_R8(i, __VA_ARGS__) DMA_WAVE_R8((i) + 8, __VA_ARGS__)
+#define DMA_WAVE_R32(i, ...) DMA_WAVE_R16(i, __VA_ARGS__) DMA_WAVE_R16((i) + 16, __VA_ARGS__)
+#define DMA_WAVE_R64(i, ...) DMA_WAVE_R32(i, __VA_ARGS__) DMA_WAVE_R32((i) + 32, __VA_ARGS__)
+#define DMA_WAVE_R128(i, ...) DMA_WAVE_R64(i, __VA_ARGS__) DMA_WAVE_R64((i) + 64, __VA_ARGS__)
+#define DMA_WAVE_R256(i, ...) DMA_WAVE_R128(i, __VA_ARGS__) DMA_WAVE_R128((i) + 128, __VA_ARGS__)
+
+#define DMA_WAVE_TABLE(n, bits, a1, a2, a3, a4, a5) {DMA_WAVE_R##n(0, n, bits, a1, a2, a3, a4, a5)}
+
+#endif /* SOURCES_DMAWAVE_H_ */
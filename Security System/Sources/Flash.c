@@ -0,0 +1,81 @@
+/*******************************************************************************
+* Flash.c - A module for erasing and programming the internal program flash
+*           through the FTFE command interface. Only used on the sector at
+*           FLASH_NV_ADDR, which is in program flash block 1 so the code
+*           running from block 0 can keep executing while a command runs.
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#include "MCUType.h"
+#include "Flash.h"
+
+#define FTFE_CMD_PGM8 0x07u
+#define FTFE_CMD_ERSSCR 0x09u
+#define FTFE_ERR_MASK (FTFE_FSTAT_ACCERR_MASK|FTFE_FSTAT_FPVIOL_MASK|FTFE_FSTAT_MGSTAT0_MASK)
+
+static INT8U flashCommand(void);
+
+/********************************************************************
+* FlashEraseSector - Erases one 4KB program flash sector
+*
+* Description:  Loads the erase flash sector command with the address and
+*               runs it.
+*
+* Return value: 0 on success, else the FTFE error flags
+*
+* Arguments:    Address inside the sector
+********************************************************************/
+INT8U FlashEraseSector(INT32U addr){
+    while((FTFE_FSTAT & FTFE_FSTAT_CCIF_MASK) == 0){}
+    FTFE_FSTAT = (FTFE_FSTAT_ACCERR_MASK|FTFE_FSTAT_FPVIOL_MASK);
+    FTFE_FCCOB0 = FTFE_CMD_ERSSCR;
+    FTFE_FCCOB1 = (INT8U)(addr >> 16);
+    FTFE_FCCOB2 = (INT8U)(addr >> 8);
+    FTFE_FCCOB3 = (INT8U)(addr & ~(FLASH_SECTOR_SIZE - 1) & 0xFFu);
+    return(flashCommand());
+}
+/********************************************************************
+* FlashProgramPhrase - Programs one 8 byte phrase
+*
+* Description:  Loads the program phrase command. The FCCOB data bytes are
+*               most significant byte first within each word.
+*
+* Return value: 0 on success, else the FTFE error flags
+*
+* Arguments:    Phrase aligned address and the two words to be written
+********************************************************************/
+INT8U FlashProgramPhrase(INT32U addr, const INT32U *data){
+    while((FTFE_FSTAT & FTFE_FSTAT_CCIF_MASK) == 0){}
+    FTFE_FSTAT = (FTFE_FSTAT_ACCERR_MASK|FTFE_FSTAT_FPVIOL_MASK);
+    FTFE_FCCOB0 = FTFE_CMD_PGM8;
+    FTFE_FCCOB1 = (INT8U)(addr >> 16);
+    FTFE_FCCOB2 = (INT8U)(addr >> 8);
+    FTFE_FCCOB3 = (INT8U)(addr & 0xF8u);
+    FTFE_FCCOB4 = (INT8U)(data[0] >> 24);
+    FTFE_FCCOB5 = (INT8U)(data[0] >> 16);
+    FTFE_FCCOB6 = (INT8U)(data[0] >> 8);
+    FTFE_FCCOB7 = (INT8U)data[0];
+    FTFE_FCCOB8 = (INT8U)(data[1] >> 24);
+    FTFE_FCCOB9 = (INT8U)(data[1] >> 16);
+    FTFE_FCCOBA = (INT8U)(data[1] >> 8);
+    FTFE_FCCOBB = (INT8U)data[1];
+    return(flashCommand());
+}
+/********************************************************************
+* flashCommand - Launches the loaded command and waits for it
+*
+* Description:  Writing CCIF starts the command. Interrupts are masked while
+*               it runs so no handler touches flash mid command.
+*
+* Return value: 0 on success, else the FTFE error flags
+*
+* Arguments:    None
+********************************************************************/
+static INT8U flashCommand(void){
+    __disable_irq();
+    FTFE_FSTAT = FTFE_FSTAT_CCIF_MASK;
+    while((FTFE_FSTAT & FTFE_FSTAT_CCIF_MASK) == 0){}
+    __enable_irq();
+    return((INT8U)(FTFE_FSTAT & FTFE_ERR_MASK));
+}
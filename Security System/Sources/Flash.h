@@ -0,0 +1,30 @@
+/*******************************************************************************
+* Flash.h - Project header file for Flash.c
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#ifndef SOURCES_FLASH_H_
+#define SOURCES_FLASH_H_
+
+#define FLASH_SECTOR_SIZE 0x1000u
+#define FLASH_NV_ADDR 0x001FF000u   //Last sector, kept out of m_text by the linker file
+
+/********************************************************************
+* FlashEraseSector - Erases one 4KB program flash sector
+*
+* Return value: 0 on success, else the FTFE error flags
+*
+* Arguments:    Address inside the sector
+********************************************************************/
+INT8U FlashEraseSector(INT32U addr);
+/********************************************************************
+* FlashProgramPhrase - Programs one 8 byte phrase
+*
+* Return value: 0 on success, else the FTFE error flags
+*
+* Arguments:    Phrase aligned address and the two words to be written
+********************************************************************/
+INT8U FlashProgramPhrase(INT32U addr, const INT32U *data);
+
+#endif /* SOURCES_FLASH_H_ */
@@ -0,0 +1,102 @@
+/*******************************************************************************
+* Goertzel.c - Fixed point Goertzel filter, the power in one DFT bin
+*
+* Description: s[i] = x[i] + 2cos(w)*s[i-1] - s[i-2] with a GOERTZEL_Q
+*              coefficient and 32 bit states, one 32x32 multiply a sample.
+*              At the bin frequency the states grow by about n*A/(2sin(w))
+*              over a block, so 16 bit input and n up to 4096 fit unless
+*              w is within a couple of bins of 0 or pi. No hardware is
+*              touched, so Tools/goertzel_test.c links this file on a host
+*              to check it with synthetic signals.
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#include "MCUType.h"
+#include "Goertzel.h"
+
+static INT32U goertzelSqrt(INT64U x);
+
+/********************************************************************
+* GoertzelInit - Clears a filter for a new block
+*
+* Return value: None
+*
+* Arguments:    The filter, its coefficient 2cos(2pi*k/n) in GOERTZEL_Q
+********************************************************************/
+void GoertzelInit(GOERTZEL *filt, INT32S coeff){
+    filt->coeff = coeff;
+    filt->s1 = 0;
+    filt->s2 = 0;
+}
+/********************************************************************
+* GoertzelRun - Runs samples through a filter
+*
+* Description:  The product is rounded back to the input units.
+*
+* Return value: None
+*
+* Arguments:    The filter, the samples, number of samples
+********************************************************************/
+void GoertzelRun(GOERTZEL *filt, const INT16S *samples, INT16U num){
+    INT32S coeff = filt->coeff;
+    INT32S s1 = filt->s1;
+    INT32S s2 = filt->s2;
+    INT32S s0;
+    INT16U i;
+
+    for(i = 0; i < num; i++){
+        s0 = samples[i] + (INT32S)((((INT64S)coeff*s1) + (1 << (GOERTZEL_Q - 1))) >> GOERTZEL_Q) - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+    filt->s1 = s1;
+    filt->s2 = s2;
+}
+/********************************************************************
+* GoertzelAmplitude - Peak amplitude of the filter's bin
+*
+* Description:  |X|^2 = s1^2 + s2^2 - 2cos(w)*s1*s2 and the amplitude is
+*               2|X|/n.
+*
+* Return value: Peak amplitude of that frequency, input units
+*
+* Arguments:    The filter, block length n
+********************************************************************/
+INT32U GoertzelAmplitude(const GOERTZEL *filt, INT16U n){
+    INT64S s1 = filt->s1;
+    INT64S s2 = filt->s2;
+    INT64S power;
+
+    power = (s1*s1) + (s2*s2) - ((((INT64S)filt->coeff*s1) >> GOERTZEL_Q)*s2);
+    if(power < 0){
+        power = 0;                  //Rounding only
+    } else{
+    }
+    return((2*goertzelSqrt((INT64U)power) + (n/2))/n);
+}
+/********************************************************************
+* goertzelSqrt - Integer square root, rounded down
+*
+* Return value: floor(sqrt(x))
+*
+* Arguments:    x
+********************************************************************/
+static INT32U goertzelSqrt(INT64U x){
+    INT64U root = 0;
+    INT64U bit = (1uLL << 62);
+
+    while(bit > x){
+        bit >>= 2;
+    }
+    while(bit != 0){
+        if(x >= (root + bit)){
+            x -= (root + bit);
+            root = (root >> 1) + bit;
+        } else{
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return((INT32U)root);
+}
@@ -0,0 +1,48 @@
+/*******************************************************************************
+* Goertzel.h - Project header file for Goertzel.c
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#ifndef SOURCES_GOERTZEL_H_
+#define SOURCES_GOERTZEL_H_
+
+#define GOERTZEL_Q 14               //Coefficient fraction bits, 2cos(w) < 2
+
+typedef struct{
+    INT32S coeff;               //2cos(2pi*k/n), GOERTZEL_Q
+    INT32S s1;                  //Last two filter states, input units
+    INT32S s2;
+} GOERTZEL;
+
+/********************************************************************
+* GoertzelInit - Clears a filter for a new block
+*
+* Return value: None
+*
+* Arguments:    The filter, its coefficient 2cos(2pi*k/n) in GOERTZEL_Q
+********************************************************************/
+void GoertzelInit(GOERTZEL *filt, INT32S coeff);
+/********************************************************************
+* GoertzelRun - Runs samples through a filter
+*
+* Description:  A block can be given in any number of calls.
+*
+* Return value: None
+*
+* Arguments:    The filter, the samples, number of samples
+********************************************************************/
+void GoertzelRun(GOERTZEL *filt, const INT16S *samples, INT16U num);
+/********************************************************************
+* GoertzelAmplitude - Peak amplitude of the filter's bin
+*
+* Description:  For a block of n samples with a whole number of periods
+*               of the bin frequency, n at most 4096.
+*
+* Return value: Peak amplitude of that frequency, input units
+*
+* Arguments:    The filter, block length n
+********************************************************************/
+INT32U GoertzelAmplitude(const GOERTZEL *filt, INT16U n);
+
+#endif /* SOURCES_GOERTZEL_H_ */
@@ -0,0 +1,122 @@
+/*******************************************************************************
+* LowPower.c - A module for sleeping in LLS between events.
+*
+* Description: The wakeup sources are LLWU internal modules 4 (TSI0) and 5
+*              (RTC alarm). The RTC alarm bounds the sleep so the tasks that
+*              do not run in LLS (temperature, keypad) are still serviced.
+*              LLS can not be entered from HSRUN, so the core is dropped to
+*              PBE at the crystal frequency in RUN first, and put back to
+*              PEE in HSRUN after the wakeup. The watchdog runs from the bus
+*              clock, which stops in LLS, so it is only refreshed before
+*              sleeping.
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#include "MCUType.h"
+#include "LowPower.h"
+#include "WDog.h"
+
+#define LP_WAKE_TSI0 LLWU_ME_WUME4_MASK    //LLWU internal module 4
+#define LP_WAKE_RTCA LLWU_ME_WUME5_MASK    //LLWU internal module 5
+#define LP_PMSTAT_RUN 0x01u
+#define LP_PMSTAT_HSRUN 0x80u
+#define LP_STOPM_LLS 3
+
+static void lpRunMode(void);
+static void lpHsrunMode(void);
+
+/********************************************************************
+* LowPowerInit - Enables the LLWU interrupt
+*
+* Description:  LLS is already allowed by SMC_PMPROT in SystemInit(), and
+*               PMPROT is write once.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void LowPowerInit(void){
+    LLWU_ME = 0;
+    NVIC_ClearPendingIRQ(LLWU_IRQn);
+    NVIC_EnableIRQ(LLWU_IRQn);
+}
+/********************************************************************
+* LowPowerSleep - Sleeps in LLS until TSI0 or the RTC alarm wakes it
+*
+* Description:  Sets the RTC alarm max_s seconds ahead, enables both wakeup
+*               sources and enters LLS. On a wakeup LLWU_IRQHandler clears
+*               the sources, then the clocks are restored here before the
+*               TSI0 interrupt is serviced.
+*
+* Return value: None
+*
+* Arguments:    Most seconds to sleep
+********************************************************************/
+void LowPowerSleep(INT32U max_s){
+    RTC_TAR = RTC_TSR + max_s;                  //Also clears TAF
+    RTC_IER |= RTC_IER_TAIE(1);
+    LLWU_ME = (LP_WAKE_TSI0|LP_WAKE_RTCA);
+    WDogTask();
+
+    lpRunMode();
+    SMC_PMCTRL = (INT8U)((SMC_PMCTRL & ~SMC_PMCTRL_STOPM_MASK)|SMC_PMCTRL_STOPM(LP_STOPM_LLS));
+    (void)SMC_PMCTRL;                           //Write must finish before WFI
+    SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+    __disable_irq();
+    __WFI();
+    SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+    lpHsrunMode();
+    __enable_irq();
+}
+/********************************************************************
+* LLWU_IRQHandler - Clears the wakeup sources
+*
+* Description:  The module flags in LLWU_MF5 are cleared at the module, so
+*               the enables are cleared instead until the next sleep. An
+*               RTC alarm is disarmed here; a TSI0 wakeup is handled by
+*               TSI0_IRQHandler.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void LLWU_IRQHandler(void){
+    if((LLWU_MF5 & LLWU_MF5_MWUF5_MASK) != 0){
+        RTC_IER &= ~RTC_IER_TAIE_MASK;
+    } else{
+    }
+    LLWU_ME = 0;
+}
+/********************************************************************
+* lpRunMode - PEE/HSRUN to PBE/RUN
+*
+* Description:  Bypasses the PLL, then leaves HSRUN.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+static void lpRunMode(void){
+    MCG_C1 = (INT8U)((MCG_C1 & ~MCG_C1_CLKS_MASK)|MCG_C1_CLKS(2));
+    while((MCG_S & MCG_S_CLKST_MASK) != MCG_S_CLKST(2)){}
+    SMC_PMCTRL = (INT8U)(SMC_PMCTRL & ~SMC_PMCTRL_RUNM_MASK);
+    while(SMC_PMSTAT != LP_PMSTAT_RUN){}
+}
+/********************************************************************
+* lpHsrunMode - PBE/RUN to PEE/HSRUN
+*
+* Description:  The PLL is off in LLS so it must lock again before it is
+*               selected.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+static void lpHsrunMode(void){
+    SMC_PMCTRL = (INT8U)((SMC_PMCTRL & ~(SMC_PMCTRL_RUNM_MASK|SMC_PMCTRL_STOPM_MASK))|SMC_PMCTRL_RUNM(3));
+    while(SMC_PMSTAT != LP_PMSTAT_HSRUN){}
+    while((MCG_S & MCG_S_LOCK0_MASK) == 0){}
+    MCG_C1 = (INT8U)(MCG_C1 & ~MCG_C1_CLKS_MASK);
+    while((MCG_S & MCG_S_CLKST_MASK) != MCG_S_CLKST(3)){}
+}
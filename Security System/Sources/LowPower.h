@@ -0,0 +1,35 @@
+/*******************************************************************************
+* LowPower.h - Project header file for LowPower.c
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#ifndef SOURCES_LOWPOWER_H_
+#define SOURCES_LOWPOWER_H_
+/********************************************************************
+* LowPowerInit - Enables the LLWU interrupt
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void LowPowerInit(void);
+/********************************************************************
+* LowPowerSleep - Sleeps in LLS until TSI0 or the RTC alarm wakes it
+*
+* Description:  TSI0 should be in proximity mode first, see TSIProxEnter().
+*               Returns with the core back at full speed.
+*
+* Return value: None
+*
+* Arguments:    Most seconds to sleep
+********************************************************************/
+void LowPowerSleep(INT32U max_s);
+/********************************************************************
+* LLWU_IRQHandler - Clears the wakeup sources
+*
+* Handler must be public for linker to see it.
+********************************************************************/
+void LLWU_IRQHandler(void);
+
+#endif /* SOURCES_LOWPOWER_H_ */
@@ -66,6 +66,13 @@ INT32U SysTickDlyInit(void){
     return sterr;
 }
 
+/*****************************************************************************************
+* SysTickGetmsCount() - Returns the 1ms count since SysTickDlyInit(), used as a timestamp
+*****************************************************************************************/
+INT32U SysTickGetmsCount(void){
+    return stmsCount;
+}
+
 /*****************************************************************************************
 * SysTick_Handler() - System Tick Interrupt Handler.
 *    - setup for a 1ms periodic interrupt.
@@ -30,6 +30,13 @@ INT32U SysTickDlyInit(void);
  ***************************************************************************************/
 void SysTickWaitEvent(const INT32U period);
 
+/****************************************************************************************
+ * SysTickGetmsCount()
+ * Returns the 1ms count since SysTickDlyInit(). Wraps after 49 days, so compare
+ * timestamps by difference only.
+ ***************************************************************************************/
+INT32U SysTickGetmsCount(void);
+
 /*****************************************************************************************
 * Handler must be public for linker to see it.
 *****************************************************************************************/
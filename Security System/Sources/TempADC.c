@@ -1,8 +1,22 @@
 /*******************************************************************************
 * TempADC.c - This module initializes ADC0 and PIT1 for use of sampling the
 *             temperature via an external analog temperature sensor MCP9701.
-*             ADC0 sample triggers are received from PIT1 at 2Hz. TempADCConvert
-*             returns converted temperature value.
+*             ADC0 is run by the DMA sequencer in ADCSeq.c, one scan every
+*             PIT1 period, so no sample is lost however late the tasks run.
+*             TempADCTask() drains the MCP9701 results through a CIC decimator that gives one filtered value
+*             every TEMP_CIC_R samples, with TEMP_CIC_FRAC_BITS more
+*             resolution than the ADC. The conversion to temperature is a
+*             piecewise linear table built at compile time from MCP9701
+*             datasheet points, in centi-degrees C, see TempCal.c;
+*             LowADCPull converts that to the display unit.
+*             The temperature alarm is decided in hardware. ADC1 samples the
+*             same pin (ADC1_DP0 is ADC0_DP3) on the same PIT1 trigger with
+*             its compare function set to the alarm band, so ADC1_IRQHandler
+*             only runs when the temperature leaves the band or comes back.
+*             Both ADCs are calibrated at init. The sequencer also converts
+*             the on-chip temperature sensor, which is compared with the
+*             MCP9701 every TEMP_CHECK_SLICES to catch a failed or drifting
+*             external sensor, see tempSelfCheck().
 *
 * Created on: Nov 30, 2017
 * Author: Anthony Needles
@@ -10,37 +24,117 @@
 #include "MCUType.h"
 #include "K65TWR_GPIO.h"
 #include "TempADC.h"
+#include "SysTickDelay.h"
+#include "ADCSeq.h"
+#include "TempStats.h"
+#include "TempCal.h"
 
-#define PIT1_TIMER_VALUE 30000000
-#define TEMP_CEL_CONV_SCALE_Q15 85
-#define TEMP_CEL_CONV_OFFSET_Q15 681235
-#define TEMP_CONV_TRUNC_ERROR_FIX 0x4000u
-#define TEMP_FAHR_CONV_SCALE_Q15 153
-#define TEMP_FAHR_CONV_OFFSET_Q15 177648
+#define TEMP_BUS_CLK_HZ 60000000
+#define TEMP_FS_HZ ADC_SEQ_RATE_HZ      //ADC sample rate
+#define PIT1_TIMER_VALUE ((TEMP_BUS_CLK_HZ/TEMP_FS_HZ) - 1)
+#define TEMP_CIC_ORDER 3
+#define TEMP_CIC_R_SHIFT 5              //Decimate by 32, 2Hz out
+#define TEMP_CIC_R (1u << TEMP_CIC_R_SHIFT)
+#define TEMP_CIC_FRAC_BITS TEMP_CAL_FRAC_BITS  //Extra bits kept from the CIC gain
+#define TEMP_CIC_OUT_SHIFT ((TEMP_CIC_ORDER*TEMP_CIC_R_SHIFT) - TEMP_CIC_FRAC_BITS)
+#if ((16 + (TEMP_CIC_ORDER*TEMP_CIC_R_SHIFT)) > 32)
+#error "CIC gain overflows the 32 bit integrators"
+#endif
+#if ((TEMP_FS_HZ/TEMP_CIC_R) != TEMP_STATS_RATE_HZ)
+#error "TempStats window rate does not match the decimator output"
+#endif
+#define TEMP_ALARM_LOW_CENTI 0          //Alarm under 0C (32F)
+#define TEMP_ALARM_HIGH_CENTI 4000      //Alarm over 40C (104F)
+#define TEMP_ALARM_HYST_CENTI 50        //Must be this far back in to clear
+#define TEMP_CHECK_SLICES 1000          //Self check every 10s of TempADCTask calls
+#define TEMP_DIE_VTEMP25_UV10 7160      //Die sensor at 25C, 0.1mV
+#define TEMP_DIE_SLOPE_UV100 162        //Die sensor slope, 0.01mV/C
+#define TEMP_CHECK_MAX_CENTI 1500       //Largest die minus MCP9701 accepted
+#define TEMP_CHECK_DRIFT_CENTI 500      //Largest change of that from the first check
+#define TEMP_TIME_STEP_SHIFT 12         //Codes timed, one every 4096 of 2^20
+
+static INT8U tempScanOut;
+static INT32U tempInteg[TEMP_CIC_ORDER];
+static INT32U tempComb[TEMP_CIC_ORDER];
+static INT8U tempDecimCount;
+static INT8U tempWarmup;
+static INT32U tempFiltered;             //ADC counts, TEMP_CIC_FRAC_BITS fraction
+static TEMP_SAMPLE tempSample;          //Published by tempPublish()
+static volatile INT8U tempAlarm;
+static INT16U tempAlarmLow;             //Compare values, 16 bit ADC codes
+static INT16U tempAlarmHigh;
+static INT16U tempClearLow;
+static INT16U tempClearHigh;
+static INT16U tempCalPG[2];             //ADC0, ADC1 calibration results
+static INT16U tempCalMG[2];
+static INT8U tempFault;
+static INT16U tempCheckCount;
+static INT8U tempCheckFirst;
+static INT32S tempCheckOffset;          //Die minus MCP9701 at the first check
+static INT32U tempCalCycles;            //Slowest TempCalCodeToCenti(), for the debugger
+static volatile INT32S tempCalSink;
+
+static void tempCIC(INT16U sample);
+static void tempPublish(void);
+static void tempAlarmOutside(void);
+static void tempAlarmInside(void);
+static INT8U tempADCCal(ADC_Type *adc, INT8U index);
+static void tempSelfCheck(INT8U scan);
+static void tempTimeCal(void);
 
 /********************************************************************
-* TempADCInit - Initializes ADC0
+* TempADCInit - Initializes ADC0 and ADC1
 *
-* Description:  Enables ADC0 for triggering from PIT1. Configures ADC0 for
-*               16 bit samples at 60MHz/8 = 7.5MHz, with a hardware trigger,
-*               hardware averaging 32 samples, with a source of DADP3.
+* Description:  ADC0 is handed to the sequencer, see ADCSeqInit(), which
+*               converts DADP3 and the on-chip sensor each PIT1 period at
+*               16 bit, 60MHz/8 = 7.5MHz, hardware averaging 32 samples.
+*               ADC1 is set up the same on DADP0, triggered by PIT1, with its
+*               conversion complete interrupt, but with the compare function
+*               on so COCO only sets for a result out of the alarm band, see
+*               ADC1_IRQHandler. The band limits are converted to ADC codes
+*               through the calibration table.
+*               Both ADCs are calibrated first, a failure is reported by
+*               TempADCFault(). The table conversion is timed once, see
+*               tempTimeCal().
 *
 * Return value: None
 *
 * Arguments:    None
 ********************************************************************/
 void TempADCInit(void){
-    SIM_SCGC6 |= (SIM_SCGC6_ADC0_MASK);
-    SIM_SOPT7 |= (SIM_SOPT7_ADC0ALTTRGEN(1)|SIM_SOPT7_ADC0TRGSEL(5));
-    ADC0_CFG1 |= (ADC_CFG1_ADIV(3)|ADC_CFG1_MODE(3)|ADC_CFG1_ADICLK(0));
-    ADC0_SC2 |= (ADC_SC2_ADTRG(1));
-    ADC0_SC3 |= (ADC_SC3_AVGE(1)|ADC_SC3_AVGS(3));
-    ADC0_SC1A = (ADC_SC1_ADCH(3));
+    SIM_SCGC6 |= SIM_SCGC6_ADC0_MASK;
+    SIM_SCGC3 |= SIM_SCGC3_ADC1_MASK;
+    tempFault = 0;
+    if((tempADCCal(ADC0, 0) != 0) || (tempADCCal(ADC1, 1) != 0)){
+        tempFault |= TEMP_FAULT_CAL;
+    } else{
+    }
+    tempCheckCount = 0;
+    tempCheckFirst = 1;
+    ADCSeqInit();
+    tempScanOut = ADCSeqScanIndex();
+    tempWarmup = TEMP_CIC_ORDER;
+    tempSample.seq = 0;
+
+    tempAlarmLow = TempCalCentiToCode(TEMP_ALARM_LOW_CENTI);
+    tempAlarmHigh = TempCalCentiToCode(TEMP_ALARM_HIGH_CENTI);
+    tempClearLow = TempCalCentiToCode(TEMP_ALARM_LOW_CENTI + TEMP_ALARM_HYST_CENTI);
+    tempClearHigh = TempCalCentiToCode(TEMP_ALARM_HIGH_CENTI - TEMP_ALARM_HYST_CENTI);
+    tempTimeCal();
+    tempAlarm = 0;
+    SIM_SOPT7 |= (SIM_SOPT7_ADC1ALTTRGEN(1)|SIM_SOPT7_ADC1TRGSEL(5));
+    ADC1_CFG1 |= (ADC_CFG1_ADIV(3)|ADC_CFG1_MODE(3)|ADC_CFG1_ADICLK(0));
+    ADC1_SC3 |= (ADC_SC3_AVGE(1)|ADC_SC3_AVGS(3));
+    tempAlarmOutside();
+    ADC1_SC1A = (ADC_SC1_AIEN(1)|ADC_SC1_ADCH(0));
+    NVIC_ClearPendingIRQ(ADC1_IRQn);
+    NVIC_EnableIRQ(ADC1_IRQn);
 }
 /********************************************************************
 * TempADCPIT1Init - Initializes PIT1
 *
-* Description:  Enables PIT1 for use of triggering ADC0 at 2Hz.
+* Description:  Enables PIT1 for use of starting ADC0 sequencer scans and
+*               ADC1 conversions at TEMP_FS_HZ.
 *
 * Return value: None
 *
@@ -53,50 +147,325 @@ void TempADCPIT1Init(void){
     PIT_LDVAL1 = PIT1_TIMER_VALUE;
 }
 /********************************************************************
-* TempADCPIT1Init - Initializes PIT1
+* TempADCTask - Drains the sequencer ring into the decimator
+*
+* Description:  The MCP9701 result of every completed scan from tempScanOut
+*               up to the one being written goes through tempCIC(). At
+*               TEMP_FS_HZ and a 10ms slice only one or two are waiting.
+*               Also runs the sensor self check on the latest scan.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void TempADCTask(void){
+    INT8U scan_in;
+
+    scan_in = ADCSeqScanIndex();
+    while(tempScanOut != scan_in){
+        tempCIC(ADCSeqRead(tempScanOut, ADC_SEQ_MCP9701));
+        tempScanOut = (INT8U)((tempScanOut + 1) % ADC_SEQ_DEPTH);
+    }
+    tempSelfCheck((INT8U)((scan_in + ADC_SEQ_DEPTH - 1) % ADC_SEQ_DEPTH));
+}
+/********************************************************************
+* TempADCFault - Returns the ADC and sensor fault bits
+*
+* Return value: TEMP_FAULT_CAL and/or TEMP_FAULT_SENSOR, 0 if none
+*
+* Arguments:    None
+********************************************************************/
+INT8U TempADCFault(void){
+    return(tempFault);
+}
+/********************************************************************
+* TempADCGetSample - Copies the latest published sample
+*
+* Description:  The snapshot is only written by TempADCTask(), so any other
+*               task gets a consistent copy. The TEMP_ALARM_RANGE bit and
+*               the fault bits are filled in at the time of the call since
+*               they can change between samples.
+*
+* Return value: None
+*
+* Arguments:    Where to copy the sample
+********************************************************************/
+void TempADCGetSample(TEMP_SAMPLE *sample){
+    *sample = tempSample;
+    if(tempAlarm != 0){
+        sample->alarm |= TEMP_ALARM_RANGE;
+    } else{
+    }
+    sample->fault = tempFault;
+}
+/********************************************************************
+* TempADCAlarm - Returns the hardware temperature alarm state
+*
+* Return value: 1 while the temperature is out of the alarm band, else 0
+*
+* Arguments:    None
+********************************************************************/
+INT8U TempADCAlarm(void){
+    return(tempAlarm);
+}
+/********************************************************************
+* ADC1_IRQHandler - ADC1 compare match
+*
+* Description:  Only a result that meets the current compare condition
+*               completes, so this runs once when the temperature leaves the
+*               alarm band, then the compare is turned around to wait for it
+*               to come back inside the band less the hysteresis, and so on.
 *
-* Description:  Samples from the ADC0 and converts the number to either it's
-*               correct value in C/F depending on argument. Saturates to -10/125
-*               and 14/257 for C/F respectively.
-*               Note: TEMP_CONV_TRUNC_ERROR_FIX adds one to the MSB to be
-*               truncated, which effectively rounds up.
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void ADC1_IRQHandler(void){
+    (void)ADC1_RA;                          //Clears COCO
+    if(tempAlarm == 0){
+        tempAlarm = 1;
+        tempAlarmInside();
+    } else{
+        tempAlarm = 0;
+        tempAlarmOutside();
+    }
+}
+/********************************************************************
+* TempCentiToUnit - Converts a sample to whole display units
+*
+* Description:  Converts centi-degrees C to whole degrees C or F depending
+*               on argument, rounded to nearest. The saturation limits of
+*               the table give -10/125 and 14/257 for C/F respectively.
 *
 * Return value: Signed value of converted temperature value
 *
-* Arguments:    The selection for which units to display the temp, 1=F, 0=C
+* Arguments:    Temperature in 0.01 C, the selection for which units to
+*               display the temp, 0xFF=F, 0=C
 ********************************************************************/
-INT32S LowADCPull(INT8U TempUnitSelect){
-    INT32U temp_sample;
-    INT32S actual_temp;
+INT32S TempCentiToUnit(INT32S centi, INT8U TempUnitSelect){
+    INT32S actual_temp = 0;
 
-    temp_sample = ADC0_RA;
     switch(TempUnitSelect){
         case(0x0):
-            if(temp_sample < 4172){
-                actual_temp = -10;
-            } else if(temp_sample > 56372){
-                actual_temp = 125;
-            } else{
-                actual_temp = (TEMP_CEL_CONV_SCALE_Q15*temp_sample);
-                actual_temp = (actual_temp - TEMP_CEL_CONV_OFFSET_Q15);
-                actual_temp = (actual_temp + TEMP_CONV_TRUNC_ERROR_FIX);
-                actual_temp = (actual_temp >> 15);
-            }
             break;
         case(0xFF):
-            if(temp_sample < 4172){
-                actual_temp = 14;
-            } else if(temp_sample > 56372){
-                actual_temp = 257;
-            } else{
-                actual_temp = (TEMP_FAHR_CONV_SCALE_Q15*temp_sample);
-                actual_temp = (actual_temp - TEMP_FAHR_CONV_OFFSET_Q15);
-                actual_temp = (actual_temp + TEMP_CONV_TRUNC_ERROR_FIX);
-                actual_temp = (actual_temp >> 15);
-            }
+            centi = ((centi*9)/5) + 3200;
             break;
         default:
             break;
     }
+    if(centi < 0){
+        actual_temp = -((50 - centi)/100);
+    } else{
+        actual_temp = ((centi + 50)/100);
+    }
     return (actual_temp);
 }
+/********************************************************************
+* tempCIC - One input sample of the CIC decimator
+*
+* Description:  TEMP_CIC_ORDER integrators run at TEMP_FS_HZ and the same
+*               number of combs at TEMP_FS_HZ/TEMP_CIC_R. The gain is
+*               TEMP_CIC_R^TEMP_CIC_ORDER and the integrators are allowed to
+*               wrap, the combs undo it as long as the gain fits in 32 bits.
+*               The output is scaled back to ADC counts keeping
+*               TEMP_CIC_FRAC_BITS of the gain as fraction. The first
+*               TEMP_CIC_ORDER outputs are still filling the combs and are
+*               not published.
+*
+* Return value: None
+*
+* Arguments:    16 bit ADC sample
+********************************************************************/
+static void tempCIC(INT16U sample){
+    INT32U acc = sample;
+    INT32U diff;
+    INT8U i;
+
+    for(i = 0; i < TEMP_CIC_ORDER; i++){
+        tempInteg[i] += acc;
+        acc = tempInteg[i];
+    }
+    tempDecimCount++;
+    if(tempDecimCount >= TEMP_CIC_R){
+        tempDecimCount = 0;
+        for(i = 0; i < TEMP_CIC_ORDER; i++){
+            diff = acc - tempComb[i];
+            tempComb[i] = acc;
+            acc = diff;
+        }
+        if(tempWarmup > 0){
+            tempWarmup--;
+        } else{
+            tempFiltered = ((acc + (1uL << (TEMP_CIC_OUT_SHIFT - 1))) >> TEMP_CIC_OUT_SHIFT);
+            tempPublish();
+        }
+    } else{
+    }
+}
+/********************************************************************
+* tempPublish - Publishes the latest decimator output
+*
+* Description:  The only place the table conversion runs, once per output.
+*               The sample goes to the rolling statistics first so the
+*               published TEMP_ALARM_RATE bit includes it.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+static void tempPublish(void){
+    INT32S centi = TempCalCodeToCenti(tempFiltered);
+
+    TempStatsAdd(centi);
+    tempSample.centi = centi;
+    tempSample.time = SysTickGetmsCount();
+    if(TempStatsRateAlarm() != 0){
+        tempSample.alarm = TEMP_ALARM_RATE;
+    } else{
+        tempSample.alarm = 0;
+    }
+    tempSample.seq++;
+}
+/********************************************************************
+* tempAlarmOutside - Compare for a result outside the alarm band
+*
+* Description:  ACFGT=0, ACREN=1 with CV1 <= CV2 completes when
+*               result < CV1 or result > CV2.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+static void tempAlarmOutside(void){
+    ADC1_CV1 = tempAlarmLow;
+    ADC1_CV2 = tempAlarmHigh;
+    ADC1_SC2 = (ADC_SC2_ADTRG(1)|ADC_SC2_ACFE(1)|ADC_SC2_ACFGT(0)|ADC_SC2_ACREN(1));
+}
+/********************************************************************
+* tempAlarmInside - Compare for a result back inside the alarm band
+*
+* Description:  ACFGT=1, ACREN=1 with CV1 <= CV2 completes when
+*               CV1 <= result <= CV2. The limits are moved in by
+*               TEMP_ALARM_HYST_CENTI.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+static void tempAlarmInside(void){
+    ADC1_CV1 = tempClearLow;
+    ADC1_CV2 = tempClearHigh;
+    ADC1_SC2 = (ADC_SC2_ADTRG(1)|ADC_SC2_ACFE(1)|ADC_SC2_ACFGT(1)|ADC_SC2_ACREN(1));
+}
+/********************************************************************
+* tempADCCal - Runs the ADC calibration sequence
+*
+* Description:  Calibrates with 32 sample hardware averaging and ADCK at
+*               bus/2/8 = 3.75MHz, under the 4MHz the reference manual asks
+*               for, then loads the plus and minus side gains from the CLPx
+*               and CLMx results. The gains are also kept in tempCalPG/MG.
+*               The ADC is left in software trigger mode.
+*
+* Return value: 0 on success, else the CALF flag
+*
+* Arguments:    ADC base and its index in tempCalPG/MG
+********************************************************************/
+static INT8U tempADCCal(ADC_Type *adc, INT8U index){
+    INT32U sum;
+    INT8U calf;
+
+    ADC_CFG1_REG(adc) = (ADC_CFG1_ADIV(3)|ADC_CFG1_MODE(3)|ADC_CFG1_ADICLK(1));
+    ADC_SC2_REG(adc) = 0;
+    ADC_SC3_REG(adc) = (ADC_SC3_AVGE(1)|ADC_SC3_AVGS(3));
+    ADC_SC3_REG(adc) |= ADC_SC3_CAL(1);
+    while((ADC_SC1_REG(adc, 0) & ADC_SC1_COCO_MASK) == 0){}
+    calf = (INT8U)(ADC_SC3_REG(adc) & ADC_SC3_CALF_MASK);
+    if(calf == 0){
+        sum = ADC_CLP0_REG(adc) + ADC_CLP1_REG(adc) + ADC_CLP2_REG(adc) +
+              ADC_CLP3_REG(adc) + ADC_CLP4_REG(adc) + ADC_CLPS_REG(adc);
+        tempCalPG[index] = (INT16U)((sum >> 1) | 0x8000u);
+        sum = ADC_CLM0_REG(adc) + ADC_CLM1_REG(adc) + ADC_CLM2_REG(adc) +
+              ADC_CLM3_REG(adc) + ADC_CLM4_REG(adc) + ADC_CLMS_REG(adc);
+        tempCalMG[index] = (INT16U)((sum >> 1) | 0x8000u);
+        ADC_PG_REG(adc) = tempCalPG[index];
+        ADC_MG_REG(adc) = tempCalMG[index];
+    } else{
+    }
+    (void)ADC_R_REG(adc, 0);
+    ADC_CFG1_REG(adc) = 0;
+    ADC_SC3_REG(adc) = 0;
+    return(calf);
+}
+/********************************************************************
+* tempSelfCheck - Cross-checks the MCP9701 with the on-chip sensor
+*
+* Description:  Every TEMP_CHECK_SLICES calls, once a sample has been
+*               published, the on-chip sensor result of the latest scan is
+*               converted, 25C - (Vtemp - VTEMP25)/m.
+*               The die runs warmer than the board, so the first difference
+*               is taken as the offset; TEMP_FAULT_SENSOR is set if the
+*               difference is ever over TEMP_CHECK_MAX_CENTI or moves more
+*               than TEMP_CHECK_DRIFT_CENTI from that offset, and cleared
+*               once it is back within both.
+*
+* Return value: None
+*
+* Arguments:    Ring index of the latest completed scan
+********************************************************************/
+static void tempSelfCheck(INT8U scan){
+    INT32S uv10;
+    INT32S die_centi;
+    INT32S diff;
+    INT32S drift;
+
+    tempCheckCount++;
+    if((tempCheckCount >= TEMP_CHECK_SLICES) && (tempSample.seq != 0)){
+        tempCheckCount = 0;
+        uv10 = (INT32S)((ADCSeqRead(scan, ADC_SEQ_DIE_TEMP)*(INT32U)TEMP_VREF_UV10) >> 16);
+        die_centi = 2500 - (((uv10 - TEMP_DIE_VTEMP25_UV10)*1000)/TEMP_DIE_SLOPE_UV100);
+        diff = die_centi - tempSample.centi;
+        if(tempCheckFirst != 0){
+            tempCheckFirst = 0;
+            tempCheckOffset = diff;
+        } else{
+        }
+        drift = diff - tempCheckOffset;
+        if((diff > TEMP_CHECK_MAX_CENTI) || (diff < -TEMP_CHECK_MAX_CENTI) ||
+           (drift > TEMP_CHECK_DRIFT_CENTI) || (drift < -TEMP_CHECK_DRIFT_CENTI)){
+            tempFault |= TEMP_FAULT_SENSOR;
+        } else{
+            tempFault &= (INT8U)~TEMP_FAULT_SENSOR;
+        }
+    } else{
+    }
+}
+/********************************************************************
+* tempTimeCal - Times TempCalCodeToCenti() with the DWT cycle counter
+*
+* Description:  Codes spread over the whole range, every segment and both
+*               saturated ends, each call timed alone. The slowest is kept
+*               in tempCalCycles, the two CYCCNT reads included.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+static void tempTimeCal(void){
+    INT32U code;
+    INT32U start;
+    INT32U cycles;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    tempCalCycles = 0;
+    for(code = 0; code < (1uL << (16 + TEMP_CAL_FRAC_BITS)); code += (1uL << TEMP_TIME_STEP_SHIFT)){
+        start = DWT->CYCCNT;
+        tempCalSink = TempCalCodeToCenti(code);
+        cycles = DWT->CYCCNT - start;
+        if(cycles > tempCalCycles){
+            tempCalCycles = cycles;
+        } else{
+        }
+    }
+}
@@ -6,12 +6,27 @@
 *******************************************************************************/
 #ifndef SOURCES_TEMPADC_H_
 #define SOURCES_TEMPADC_H_
+
+#define TEMP_FAULT_CAL 0x1u         //ADC calibration failed
+#define TEMP_FAULT_SENSOR 0x2u      //MCP9701 disagrees with the on-chip sensor
+#define TEMP_ALARM_RANGE 0x1u       //Hardware compare, out of 0-40C
+#define TEMP_ALARM_RATE 0x2u        //Rate-of-rise, see TempStats.c
+
+typedef struct{
+    INT32S centi;               //Temperature, 0.01C
+    INT32U time;                //SysTickGetmsCount() when published
+    INT32U seq;                 //Counts published samples, 0 before the first
+    INT8U alarm;                //TEMP_ALARM_RANGE and/or TEMP_ALARM_RATE
+    INT8U fault;                //TempADCFault() bits
+} TEMP_SAMPLE;
+
 /********************************************************************
-* TempADCInit - Initializes ADC0
+* TempADCInit - Initializes ADC0 and ADC1
 *
-* Description:  Enables ADC0 for triggering from PIT1. Configures ADC0 for
-*               16 bit samples at 60MHz/8 = 7.5MHz, with a hardware trigger,
-*               hardware averaging 32 samples, with a source of DADP3.
+* Description:  Calibrates both ADCs, hands ADC0 to the sequencer in
+*               ADCSeq.c for DADP3 and the on-chip sensor, and sets ADC1 up
+*               on DADP0 with the hardware alarm compare. All conversions
+*               are 16 bit at 60MHz/8 = 7.5MHz, hardware averaging 32 samples.
 *
 * Return value: None
 *
@@ -21,7 +36,8 @@ void TempADCInit(void);
 /********************************************************************
 * TempADCPIT1Init - Initializes PIT1
 *
-* Description:  Enables PIT1 for use of triggering ADC0 at 2Hz.
+* Description:  Enables PIT1 for use of starting ADC0 sequencer scans and
+*               ADC1 conversions at ADC_SEQ_RATE_HZ.
 *
 * Return value: None
 *
@@ -29,18 +45,67 @@ void TempADCInit(void);
 ********************************************************************/
 void TempADCPIT1Init(void);
 /********************************************************************
-* TempADCPIT1Init - Initializes PIT1
+* TempADCTask - Drains the DMA sample ring into the decimator
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void TempADCTask(void);
+/********************************************************************
+* TempADCGetSample - Copies the latest published sample
+*
+* Description:  Each decimator output is converted once to 0.01C and
+*               published with a timestamp and sequence number. Consumers
+*               keep the last seq they handled to see a new sample, so any
+*               number of them can read it. Alarm and fault bits are
+*               current as of the call.
+*
+* Return value: None
+*
+* Arguments:    Where to copy the sample
+********************************************************************/
+void TempADCGetSample(TEMP_SAMPLE *sample);
+/********************************************************************
+* TempADCFault - Returns the ADC and sensor fault bits
+*
+* Description:  TEMP_FAULT_CAL is set at init if either ADC failed its
+*               calibration. TEMP_FAULT_SENSOR is kept by the periodic cross
+*               check of the MCP9701 against the on-chip temperature sensor.
+*
+* Return value: TEMP_FAULT_CAL and/or TEMP_FAULT_SENSOR, 0 if none
+*
+* Arguments:    None
+********************************************************************/
+INT8U TempADCFault(void);
+/********************************************************************
+* TempADCAlarm - Returns the hardware temperature alarm state
+*
+* Description:  Set and cleared by ADC1_IRQHandler from the ADC1 compare
+*               function, 0-40C with 0.5C of hysteresis.
+*
+* Return value: 1 while the temperature is out of the alarm band, else 0
+*
+* Arguments:    None
+********************************************************************/
+INT8U TempADCAlarm(void);
+/********************************************************************
+* ADC1_IRQHandler - ADC1 compare match
+*
+* Handler must be public for linker to see it.
+********************************************************************/
+void ADC1_IRQHandler(void);
+/********************************************************************
+* TempCentiToUnit - Converts a sample to whole display units
 *
-* Description:  Samples from the ADC0 and converts the number to either it's
-*               correct value in C/F depending on argument. Saturates to -10/125
-*               and 14/257 for C/F respectively.
-*               Note: TEMP_CONV_TRUNC_ERROR_FIX adds one to the MSB to be
-*               truncated, which effectively rounds up.
+* Description:  Rounded to nearest. Saturates to -10/125 and 14/257 for C/F
+*               respectively.
 *
 * Return value: Signed value of converted temperature value
 *
-* Arguments:    The selection for which units to display the temp, 1=F, 0=C
+* Arguments:    Temperature in 0.01 C, the selection for which units to
+*               display the temp, 0xFF=F, 0=C
 ********************************************************************/
-INT32S LowADCPull(INT8U TempUnitSelect);
+INT32S TempCentiToUnit(INT32S centi, INT8U TempUnitSelect);
 
 #endif /* SOURCES_TEMPADC_H_ */
@@ -0,0 +1,113 @@
+/*******************************************************************************
+* TempCal.c - MCP9701 calibration table and conversions for TempADC.c
+*
+* Description: The table is a piecewise linear fit built by the compiler
+*              from datasheet points, in ADC codes with TEMP_CAL_FRAC_BITS
+*              fraction against centi-degrees C. No hardware is touched so
+*              Tools/tempcal_test.c links this file to check every code.
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#include "MCUType.h"
+#include "TempCal.h"
+
+/* MCP9701 datasheet points, temperature in 0.01C and Vout in 0.1mV. These are
+ * the typical transfer function, Vout = 400mV + 19.5mV/C. Measured points from
+ * a board can replace them, they only need to be in increasing order. */
+#define TEMP_CAL_P0 -1000,  2050
+#define TEMP_CAL_P1     0,  4000
+#define TEMP_CAL_P2  2500,  8875
+#define TEMP_CAL_P3  5000, 13750
+#define TEMP_CAL_P4  7500, 18625
+#define TEMP_CAL_P5 10000, 23500
+#define TEMP_CAL_P6 12500, 28375
+#define TEMP_CAL_LAST TEMP_CAL_P6
+#define TEMP_CAL_NUM_SEGS 6
+
+/* Vout to the 16 bit ADC code with TEMP_CAL_FRAC_BITS fraction, rounded */
+#define TEMP_CAL_CODE(uv10) ((INT32U)((((INT64U)(uv10) << (16 + TEMP_CAL_FRAC_BITS)) + (TEMP_VREF_UV10/2))/TEMP_VREF_UV10))
+#define TEMP_CAL_SLOPE_Q 24
+#define TEMP_CAL_SEG_X(c0, v0, c1, v1) {TEMP_CAL_CODE(v0), (c0), \
+        (INT32S)((((INT64S)((c1) - (c0)) << TEMP_CAL_SLOPE_Q) + ((TEMP_CAL_CODE(v1) - TEMP_CAL_CODE(v0))/2)) \
+                 /(INT64S)(TEMP_CAL_CODE(v1) - TEMP_CAL_CODE(v0)))}
+#define TEMP_CAL_SEG(p0, p1) TEMP_CAL_SEG_X(p0, p1)
+#define TEMP_CAL_CODE_OF(c, v) TEMP_CAL_CODE(v)
+#define TEMP_CAL_CENTI_OF(c, v) (c)
+#define TEMP_CAL_X(m, p) m(p)
+#define TEMP_CAL_LAST_CODE TEMP_CAL_X(TEMP_CAL_CODE_OF, TEMP_CAL_LAST)
+#define TEMP_CAL_LAST_CENTI TEMP_CAL_X(TEMP_CAL_CENTI_OF, TEMP_CAL_LAST)
+
+typedef struct{
+    INT32U code;                //Segment start, ADC code with fraction
+    INT32S centi;               //Temperature at code, 0.01C
+    INT32S slope;               //0.01C per code step, TEMP_CAL_SLOPE_Q fraction bits
+} TEMP_CAL_SEG;
+
+/* Built by the compiler from the points above */
+static const TEMP_CAL_SEG tempCal[TEMP_CAL_NUM_SEGS] = {
+    TEMP_CAL_SEG(TEMP_CAL_P0, TEMP_CAL_P1),
+    TEMP_CAL_SEG(TEMP_CAL_P1, TEMP_CAL_P2),
+    TEMP_CAL_SEG(TEMP_CAL_P2, TEMP_CAL_P3),
+    TEMP_CAL_SEG(TEMP_CAL_P3, TEMP_CAL_P4),
+    TEMP_CAL_SEG(TEMP_CAL_P4, TEMP_CAL_P5),
+    TEMP_CAL_SEG(TEMP_CAL_P5, TEMP_CAL_P6)
+};
+
+/********************************************************************
+* TempCalCodeToCenti - Converts a decimator output to centi-degrees C
+*
+* Description:  Finds the tempCal segment holding the code and interpolates
+*               along it. Codes under the first point or over the last
+*               saturate to their temperature, -10.00/125.00 C. Codes are
+*               20 bits, so the offset into the segment is cast to 32 bits
+*               and the product with the slope is one 32x32 to 64 bit SMULL.
+*
+* Return value: Temperature in 0.01 C
+*
+* Arguments:    ADC code with TEMP_CAL_FRAC_BITS fraction
+********************************************************************/
+INT32S TempCalCodeToCenti(INT32U code){
+    const TEMP_CAL_SEG *seg = &tempCal[0];
+    INT32S centi;
+    INT8U i;
+
+    if(code <= tempCal[0].code){
+        centi = tempCal[0].centi;
+    } else if(code >= TEMP_CAL_LAST_CODE){
+        centi = TEMP_CAL_LAST_CENTI;
+    } else{
+        for(i = 1; (i < TEMP_CAL_NUM_SEGS) && (code >= tempCal[i].code); i++){
+            seg = &tempCal[i];
+        }
+        centi = seg->centi + (INT32S)((((INT64S)(INT32S)(code - seg->code)*seg->slope) +
+                                       (1LL << (TEMP_CAL_SLOPE_Q - 1))) >> TEMP_CAL_SLOPE_Q);
+    }
+    return(centi);
+}
+/********************************************************************
+* TempCalCentiToCode - Inverse of the calibration table
+*
+* Description:  Only used at init so the division is not a concern.
+*
+* Return value: 16 bit ADC code for the temperature, saturated to the table
+*
+* Arguments:    Temperature in 0.01 C
+********************************************************************/
+INT16U TempCalCentiToCode(INT32S centi){
+    const TEMP_CAL_SEG *seg = &tempCal[0];
+    INT32U code;
+    INT8U i;
+
+    if(centi <= tempCal[0].centi){
+        code = tempCal[0].code;
+    } else if(centi >= TEMP_CAL_LAST_CENTI){
+        code = TEMP_CAL_LAST_CODE;
+    } else{
+        for(i = 1; (i < TEMP_CAL_NUM_SEGS) && (centi >= tempCal[i].centi); i++){
+            seg = &tempCal[i];
+        }
+        code = seg->code + (INT32U)(((INT64S)(centi - seg->centi) << TEMP_CAL_SLOPE_Q)/seg->slope);
+    }
+    return((INT16U)((code + (1u << (TEMP_CAL_FRAC_BITS - 1))) >> TEMP_CAL_FRAC_BITS));
+}
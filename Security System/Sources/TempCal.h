@@ -0,0 +1,33 @@
+/*******************************************************************************
+* TempCal.h - Project header file for TempCal.c
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#ifndef SOURCES_TEMPCAL_H_
+#define SOURCES_TEMPCAL_H_
+
+#define TEMP_VREF_UV10 33000            //ADC full scale, 0.1mV
+#define TEMP_CAL_FRAC_BITS 4            //Fraction bits of the table's codes
+
+/********************************************************************
+* TempCalCodeToCenti - Converts a decimator output to centi-degrees C
+*
+* Description:  Interpolates the calibration table, saturating at its end
+*               points, -10.00/125.00 C.
+*
+* Return value: Temperature in 0.01 C
+*
+* Arguments:    ADC code with TEMP_CAL_FRAC_BITS fraction
+********************************************************************/
+INT32S TempCalCodeToCenti(INT32U code);
+/********************************************************************
+* TempCalCentiToCode - Inverse of the calibration table
+*
+* Return value: 16 bit ADC code for the temperature, saturated to the table
+*
+* Arguments:    Temperature in 0.01 C
+********************************************************************/
+INT16U TempCalCentiToCode(INT32S centi);
+
+#endif /* SOURCES_TEMPCAL_H_ */
@@ -0,0 +1,536 @@
+/*******************************************************************************
+* TempHist.c - Compressed temperature history in SRAM_L
+*
+* Description: The whole history is one structure placed in .temp_hist, a
+*              NOLOAD section in m_data (SRAM_L, 0x1FFF0000, 64KB) that the
+*              linker file otherwise leaves empty.
+*              Hourly aggregates: min, max and sum in 0.01C of the current
+*              hour and the TEMP_HIST_HOURS before it, slot hour % the
+*              number of slots, updated with each sample.
+*              Sample ring: TEMP_HIST_BLOCKS blocks of TEMP_HIST_BLOCK_BYTES,
+*              oldest dropped first. Each block header has the RTC second of
+*              its first sample, the sample count and the first value, so a
+*              query skips whole blocks on the header alone. Samples are
+*              kept in TEMP_HIST_STEP_CENTI steps and only move a step once
+*              the temperature is a full step away, so sensor noise does
+*              not show up as deltas. The deltas are then byte tokens:
+*                0x00-0x7F  n+1 samples unchanged
+*                0x80-0xFE  one sample, zigzag delta 1-126
+*                0xFF       one sample, zigzag delta as a LEB128 varint
+*              A steady temperature costs one byte per 64s and a change one
+*              byte, so 24h at TEMP_HIST_RATE_HZ needs well under the 62KB
+*              of blocks unless the temperature moves a step almost every
+*              sample. A new block is also started when a sample is not at
+*              the time its place in the block gives, after sleep or a clock
+*              change, so sample times stay right.
+*              For offline analysis the region can be read out with a
+*              debugger and decoded on a host with this file, which does not
+*              touch any hardware, or walked on target with TempHistDump().
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#include "MCUType.h"
+#include "TempHist.h"
+
+#define TEMP_HIST_MAGIC 0x54484953uL    //"THIS"
+#define TEMP_HIST_STEP_CENTI 10         //0.1C stored resolution
+#define TEMP_HIST_BLOCK_BYTES 256
+#define TEMP_HIST_BLOCKS 254            //Leaves room for the aggregates in 64KB
+#define TEMP_HIST_SLOTS (TEMP_HIST_HOURS + 1)
+#define TEMP_HIST_S_PER_HOUR 3600
+#define TEMP_HIST_RUN_MAX 0x7Fu
+#define TEMP_HIST_DELTA 0x80u
+#define TEMP_HIST_ESC 0xFFu
+#define TEMP_HIST_NO_RUN 0xFFu
+#define TEMP_HIST_TOKEN_MAX 4           //Escape and a 3 byte varint
+#define TEMP_HIST_ORDER() __ASM volatile ("" : : : "memory")   //Keeps stores in order over a reset
+
+typedef struct{
+    INT32U start_s;             //RTC second of the first sample
+    INT16U count;               //Samples in the block
+    INT16S first;               //First sample, steps
+    INT8U len;                  //Token bytes used
+    INT8U run;                  //Index of the open run token or TEMP_HIST_NO_RUN
+    INT8U pad[2];
+} TEMP_HIST_HDR;
+
+#define TEMP_HIST_DATA_BYTES ((int)(TEMP_HIST_BLOCK_BYTES - sizeof(TEMP_HIST_HDR)))
+
+typedef struct{
+    TEMP_HIST_HDR hdr;
+    INT8U data[TEMP_HIST_DATA_BYTES];
+} TEMP_HIST_BLOCK;
+
+typedef struct{
+    INT32U hour;                //RTC seconds/3600
+    INT32S sum;                 //0.01C
+    INT16U count;
+    INT16S min;
+    INT16S max;
+    INT8U pad[2];
+} TEMP_HIST_HOUR;
+
+typedef struct{
+    INT32U magic;
+    INT32U hour;                //Hour of the latest sample
+    INT16U head;                //Oldest block
+    INT16U used;                //Blocks in use
+    INT16S last;                //Latest sample, steps
+    INT8U pad[2];
+    TEMP_HIST_HOUR hours[TEMP_HIST_SLOTS];
+    TEMP_HIST_BLOCK blocks[TEMP_HIST_BLOCKS];
+} TEMP_HIST;
+
+typedef struct{
+    INT64S sum;
+    INT32U count;
+    INT32S min;
+    INT32S max;
+    INT8U valid;                //min and max hold a value
+} TEMP_HIST_ACC;
+
+static TEMP_HIST tempHist __attribute__((section(".temp_hist")));
+
+static INT8U histBlockValid(const TEMP_HIST_BLOCK *blk);
+static void histHourAdd(INT32S centi, INT32U hour);
+static void histAppend(INT16S value, INT32U time_s);
+static void histAccAdd(TEMP_HIST_ACC *acc, INT32S value, INT32U n);
+static void histDecode(INT32U from_s, INT32U to_s, TEMP_HIST_ACC *acc,
+                       void (*emit)(INT32U time_h, INT32S centi));
+static void histWalk(const TEMP_HIST_BLOCK *blk, INT32U lo, INT32U hi, TEMP_HIST_ACC *acc,
+                     void (*emit)(INT32U time_h, INT32S centi));
+static void histStats(const TEMP_HIST_ACC *acc, TEMP_HIST_STATS *stats);
+
+/********************************************************************
+* TempHistInit - Checks the history left in SRAM_L
+*
+* Description:  A reset can land inside histAppend(), so the newest block
+*               is checked with histBlockValid() as well and dropped if it
+*               is not whole. The next sample then starts a fresh block.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void TempHistInit(void){
+    INT8U i;
+
+    if((tempHist.magic != TEMP_HIST_MAGIC) || (tempHist.head >= TEMP_HIST_BLOCKS) ||
+       (tempHist.used > TEMP_HIST_BLOCKS)){
+        tempHist.head = 0;
+        tempHist.used = 0;
+        tempHist.hour = 0;
+        tempHist.last = 0;
+        for(i = 0; i < TEMP_HIST_SLOTS; i++){
+            tempHist.hours[i].count = 0;
+        }
+        tempHist.magic = TEMP_HIST_MAGIC;
+    } else if((tempHist.used != 0) &&
+              (histBlockValid(&tempHist.blocks[(tempHist.head + tempHist.used - 1) % TEMP_HIST_BLOCKS]) == 0)){
+        tempHist.used--;
+    } else{
+    }
+}
+/********************************************************************
+* TempHistAdd - Adds one sample
+*
+* Description:  The stored value only moves once the temperature is at least
+*               a full step from it, then to the nearest step.
+*
+* Return value: None
+*
+* Arguments:    Temperature in 0.01C, RTC seconds of the sample
+********************************************************************/
+void TempHistAdd(INT32S centi, INT32U time_s){
+    INT32S value = tempHist.last;
+    INT32S diff = centi - (value*TEMP_HIST_STEP_CENTI);
+
+    histHourAdd(centi, time_s/TEMP_HIST_S_PER_HOUR);
+    if((tempHist.used == 0) || (diff >= TEMP_HIST_STEP_CENTI) || (diff <= -TEMP_HIST_STEP_CENTI)){
+        if(centi < 0){
+            value = -(((TEMP_HIST_STEP_CENTI/2) - centi)/TEMP_HIST_STEP_CENTI);
+        } else{
+            value = ((centi + (TEMP_HIST_STEP_CENTI/2))/TEMP_HIST_STEP_CENTI);
+        }
+    } else{
+    }
+    histAppend((INT16S)value, time_s);
+}
+/********************************************************************
+* TempHistRange - Min, max and average over a time range
+*
+* Description:  Whole hours from the oldest aggregate still kept on are
+*               merged from the aggregates, the parts before and after them
+*               are decoded from the ring.
+*
+* Return value: 1 if the range held any samples, else 0
+*
+* Arguments:    Range [from_s, to_s) in RTC seconds, where to put the result
+********************************************************************/
+INT8U TempHistRange(INT32U from_s, INT32U to_s, TEMP_HIST_STATS *stats){
+    TEMP_HIST_ACC acc = {0, 0, 0, 0, 0};
+    const TEMP_HIST_HOUR *slot;
+    INT32U h0 = (from_s + TEMP_HIST_S_PER_HOUR - 1)/TEMP_HIST_S_PER_HOUR;
+    INT32U h1 = to_s/TEMP_HIST_S_PER_HOUR;
+    INT32U h;
+
+    if(tempHist.hour > TEMP_HIST_HOURS){
+        if(h0 < (tempHist.hour - TEMP_HIST_HOURS)){
+            h0 = tempHist.hour - TEMP_HIST_HOURS;
+        } else{
+        }
+    } else{
+    }
+    if(h0 < h1){
+        for(h = h0; h < h1; h++){
+            slot = &tempHist.hours[h % TEMP_HIST_SLOTS];
+            if((slot->hour == h) && (slot->count != 0)){
+                histAccAdd(&acc, slot->min, 0);
+                histAccAdd(&acc, slot->max, 0);
+                acc.sum += slot->sum;
+                acc.count += slot->count;
+            } else{
+            }
+        }
+        histDecode(from_s, h0*TEMP_HIST_S_PER_HOUR, &acc, 0);
+        histDecode(h1*TEMP_HIST_S_PER_HOUR, to_s, &acc, 0);
+    } else{
+        histDecode(from_s, to_s, &acc, 0);
+    }
+    histStats(&acc, stats);
+    return((INT8U)(acc.count != 0));
+}
+/********************************************************************
+* TempHistHour - Returns an hourly aggregate
+*
+* Return value: 1 if that hour held any samples, else 0
+*
+* Arguments:    Hours before the current one, 0 to TEMP_HIST_HOURS, where
+*               to put the result
+********************************************************************/
+INT8U TempHistHour(INT8U hours_ago, TEMP_HIST_STATS *stats){
+    TEMP_HIST_ACC acc = {0, 0, 0, 0, 0};
+    const TEMP_HIST_HOUR *slot;
+    INT32U hour = tempHist.hour - hours_ago;
+
+    slot = &tempHist.hours[hour % TEMP_HIST_SLOTS];
+    if((hours_ago <= TEMP_HIST_HOURS) && (hours_ago <= tempHist.hour) &&
+       (slot->hour == hour) && (slot->count != 0)){
+        acc.sum = slot->sum;
+        acc.count = slot->count;
+        acc.min = slot->min;
+        acc.max = slot->max;
+    } else{
+    }
+    histStats(&acc, stats);
+    return((INT8U)(acc.count != 0));
+}
+/********************************************************************
+* TempHistDump - Decodes the ring for offline analysis
+*
+* Return value: None
+*
+* Arguments:    First RTC second wanted, function to call per sample
+********************************************************************/
+void TempHistDump(INT32U from_s, void (*emit)(INT32U time_h, INT32S centi)){
+    histDecode(from_s, 0xFFFFFFFFuL, 0, emit);
+}
+/********************************************************************
+* histBlockValid - Checks a block header against its tokens
+*
+* Description:  The token bytes used must fit the block, the open run must
+*               be a run token inside them, and the tokens must end on a
+*               whole token and decode to exactly the header's count, as
+*               histWalk() will read them. A reset between writing a
+*               token and counting its sample fails the last check.
+*
+* Return value: 1 if the block can be decoded and appended to, else 0
+*
+* Arguments:    The block
+********************************************************************/
+static INT8U histBlockValid(const TEMP_HIST_BLOCK *blk){
+    INT32U n = 1;
+    INT8U pos = 0;
+    INT8U token;
+    INT8U valid;
+
+    if((blk->hdr.count == 0) || (blk->hdr.len > TEMP_HIST_DATA_BYTES)){
+        valid = 0;
+    } else if((blk->hdr.run != TEMP_HIST_NO_RUN) &&
+              ((blk->hdr.run >= blk->hdr.len) || (blk->data[blk->hdr.run] > TEMP_HIST_RUN_MAX))){
+        valid = 0;
+    } else{
+        while(pos < blk->hdr.len){
+            token = blk->data[pos++];
+            if(token <= TEMP_HIST_RUN_MAX){
+                n += (INT32U)token + 1;
+            } else{
+                n++;
+                if(token == TEMP_HIST_ESC){
+                    do{
+                        token = (pos < blk->hdr.len) ? blk->data[pos] : 0;
+                        pos++;
+                    }while((token & 0x80u) != 0);
+                } else{
+                }
+            }
+        }
+        valid = (INT8U)((pos == blk->hdr.len) && (n == blk->hdr.count));
+    }
+    return(valid);
+}
+/********************************************************************
+* histHourAdd - Adds a sample to its hour's aggregate
+*
+* Description:  A slot still holding an older hour is started over. At
+*               TEMP_HIST_RATE_HZ an hour sums to under 2^31 for any value
+*               the calibration table can give.
+*
+* Return value: None
+*
+* Arguments:    Temperature in 0.01C, its hour
+********************************************************************/
+static void histHourAdd(INT32S centi, INT32U hour){
+    TEMP_HIST_HOUR *slot = &tempHist.hours[hour % TEMP_HIST_SLOTS];
+
+    if((slot->hour != hour) || (slot->count == 0)){
+        slot->hour = hour;
+        slot->sum = 0;
+        slot->count = 0;
+        slot->min = (INT16S)centi;
+        slot->max = (INT16S)centi;
+    } else{
+    }
+    if(centi < slot->min){
+        slot->min = (INT16S)centi;
+    } else if(centi > slot->max){
+        slot->max = (INT16S)centi;
+    } else{
+    }
+    slot->sum += centi;
+    slot->count++;
+    tempHist.hour = hour;
+}
+/********************************************************************
+* histAppend - Appends a sample to the newest block
+*
+* Description:  Extends the open run for an unchanged sample, else writes a
+*               delta token. A new block is started when there is no block,
+*               the newest is full or the sample is more than a second off
+*               the time its place in the block gives.
+*               A reset can land anywhere in here and TempHistInit() only
+*               checks the newest block, so the stores are ordered to keep
+*               every step valid. When the ring is full the oldest block's
+*               count is cleared before head moves past it, so if the reset
+*               comes before used is lowered the slot reads as the newest
+*               block but fails histBlockValid(). The new block only joins
+*               the ring once its whole header is written, so an old block
+*               in the reused slot is never taken as the newest.
+*
+* Return value: None
+*
+* Arguments:    Sample in steps, its RTC second
+********************************************************************/
+static void histAppend(INT16S value, INT32U time_s){
+    TEMP_HIST_BLOCK *blk = 0;
+    INT32U expect_s;
+    INT32U zz;
+    INT32S delta;
+
+    if(tempHist.used != 0){
+        blk = &tempHist.blocks[(tempHist.head + tempHist.used - 1) % TEMP_HIST_BLOCKS];
+        expect_s = blk->hdr.start_s + (blk->hdr.count/TEMP_HIST_RATE_HZ);
+        if(((time_s + 1) < expect_s) || (time_s > (expect_s + 1)) || (blk->hdr.count == 0xFFFFu) ||
+           ((blk->hdr.len + TEMP_HIST_TOKEN_MAX) > TEMP_HIST_DATA_BYTES)){
+            blk = 0;
+        } else{
+        }
+    } else{
+    }
+    if(blk == 0){
+        if(tempHist.used >= TEMP_HIST_BLOCKS){
+            tempHist.blocks[tempHist.head].hdr.count = 0;
+            TEMP_HIST_ORDER();
+            tempHist.head = (INT16U)((tempHist.head + 1) % TEMP_HIST_BLOCKS);
+            TEMP_HIST_ORDER();
+            tempHist.used--;
+        } else{
+        }
+        blk = &tempHist.blocks[(tempHist.head + tempHist.used) % TEMP_HIST_BLOCKS];
+        blk->hdr.start_s = time_s;
+        blk->hdr.count = 1;
+        blk->hdr.first = value;
+        blk->hdr.len = 0;
+        blk->hdr.run = TEMP_HIST_NO_RUN;
+        TEMP_HIST_ORDER();
+        tempHist.used++;
+    } else{
+        delta = (INT32S)value - tempHist.last;
+        if(delta == 0){
+            if((blk->hdr.run != TEMP_HIST_NO_RUN) && (blk->data[blk->hdr.run] < TEMP_HIST_RUN_MAX)){
+                blk->data[blk->hdr.run]++;
+            } else{
+                blk->hdr.run = blk->hdr.len;
+                blk->data[blk->hdr.len++] = 0;
+            }
+        } else{
+            blk->hdr.run = TEMP_HIST_NO_RUN;
+            zz = ((INT32U)delta << 1) ^ (INT32U)(delta >> 31);
+            if(zz < (TEMP_HIST_ESC - TEMP_HIST_DELTA)){
+                blk->data[blk->hdr.len++] = (INT8U)(TEMP_HIST_DELTA + zz);
+            } else{
+                blk->data[blk->hdr.len++] = TEMP_HIST_ESC;
+                while(zz >= 0x80u){
+                    blk->data[blk->hdr.len++] = (INT8U)(zz | 0x80u);
+                    zz >>= 7;
+                }
+                blk->data[blk->hdr.len++] = (INT8U)zz;
+            }
+        }
+        blk->hdr.count++;
+    }
+    tempHist.last = value;
+}
+/********************************************************************
+* histAccAdd - Adds n samples of one value to an accumulator
+*
+* Description:  With n of 0 only the min and max take in the value, used to
+*               merge an hourly aggregate.
+*
+* Return value: None
+*
+* Arguments:    Accumulator, value in 0.01C, number of samples
+********************************************************************/
+static void histAccAdd(TEMP_HIST_ACC *acc, INT32S value, INT32U n){
+    if(acc->valid == 0){
+        acc->valid = 1;
+        acc->min = value;
+        acc->max = value;
+    } else if(value < acc->min){
+        acc->min = value;
+    } else if(value > acc->max){
+        acc->max = value;
+    } else{
+    }
+    acc->sum += ((INT64S)value*n);
+    acc->count += n;
+}
+/********************************************************************
+* histDecode - Decodes the samples of a time range from the ring
+*
+* Description:  Blocks entirely outside the range are skipped on their
+*               header. Within a block sample i is at start_s + i/2.
+*
+* Return value: None
+*
+* Arguments:    Range [from_s, to_s) in RTC seconds, accumulator and/or per
+*               sample function, either may be 0
+********************************************************************/
+static void histDecode(INT32U from_s, INT32U to_s, TEMP_HIST_ACC *acc,
+                       void (*emit)(INT32U time_h, INT32S centi)){
+    const TEMP_HIST_BLOCK *blk;
+    INT32U end_s;
+    INT32U lo;
+    INT32U hi;
+    INT16U i;
+
+    for(i = 0; (i < tempHist.used) && (from_s < to_s); i++){
+        blk = &tempHist.blocks[(tempHist.head + i) % TEMP_HIST_BLOCKS];
+        end_s = blk->hdr.start_s + ((blk->hdr.count + 1)/TEMP_HIST_RATE_HZ);
+        if((blk->hdr.start_s < to_s) && (end_s > from_s)){
+            if(from_s > blk->hdr.start_s){
+                lo = (from_s - blk->hdr.start_s)*TEMP_HIST_RATE_HZ;
+            } else{
+                lo = 0;
+            }
+            if(to_s < end_s){
+                hi = (to_s - blk->hdr.start_s)*TEMP_HIST_RATE_HZ;
+            } else{
+                hi = blk->hdr.count;
+            }
+            histWalk(blk, lo, hi, acc, emit);
+        } else{
+        }
+    }
+}
+/********************************************************************
+* histWalk - Decodes samples lo to hi-1 of a block
+*
+* Description:  A run token is handled at once, so a steady temperature
+*               costs one step per 128 samples.
+*
+* Return value: None
+*
+* Arguments:    Block, sample range, accumulator and/or per sample function
+********************************************************************/
+static void histWalk(const TEMP_HIST_BLOCK *blk, INT32U lo, INT32U hi, TEMP_HIST_ACC *acc,
+                     void (*emit)(INT32U time_h, INT32S centi)){
+    INT32S value = blk->hdr.first;
+    INT32U index = 0;
+    INT32U n = 1;
+    INT32U first;
+    INT32U last;
+    INT32U zz;
+    INT8U shift;
+    INT8U pos = 0;
+    INT8U token;
+
+    while(index < hi){
+        first = (index > lo) ? index : lo;
+        last = ((index + n) < hi) ? (index + n) : hi;
+        if(first < last){
+            if(acc != 0){
+                histAccAdd(acc, value*TEMP_HIST_STEP_CENTI, last - first);
+            } else{
+            }
+            if(emit != 0){
+                for(; first < last; first++){
+                    emit((blk->hdr.start_s*TEMP_HIST_RATE_HZ) + first, value*TEMP_HIST_STEP_CENTI);
+                }
+            } else{
+            }
+        } else{
+        }
+        index += n;
+        if(pos >= blk->hdr.len){
+            hi = index;                     //No more tokens
+        } else{
+            token = blk->data[pos++];
+            if(token <= TEMP_HIST_RUN_MAX){
+                n = (INT32U)token + 1;
+            } else{
+                n = 1;
+                if(token == TEMP_HIST_ESC){
+                    zz = 0;
+                    shift = 0;
+                    do{
+                        token = blk->data[pos++];
+                        zz |= ((INT32U)(token & 0x7Fu) << shift);
+                        shift += 7;
+                    }while((token & 0x80u) != 0);
+                } else{
+                    zz = (INT32U)token - TEMP_HIST_DELTA;
+                }
+                value += ((INT32S)(zz >> 1) ^ -(INT32S)(zz & 1u));
+            }
+        }
+    }
+}
+/********************************************************************
+* histStats - Converts an accumulator to TEMP_HIST_STATS
+*
+* Return value: None
+*
+* Arguments:    Accumulator, where to put the result
+********************************************************************/
+static void histStats(const TEMP_HIST_ACC *acc, TEMP_HIST_STATS *stats){
+    stats->count = acc->count;
+    stats->min = acc->min;
+    stats->max = acc->max;
+    if(acc->count != 0){
+        stats->avg = (INT32S)(acc->sum/(INT64S)acc->count);
+    } else{
+        stats->avg = 0;
+    }
+}
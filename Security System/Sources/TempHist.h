@@ -0,0 +1,78 @@
+/*******************************************************************************
+* TempHist.h - Project header file for TempHist.c
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#ifndef SOURCES_TEMPHIST_H_
+#define SOURCES_TEMPHIST_H_
+
+#define TEMP_HIST_RATE_HZ 2             //Samples per second added
+#define TEMP_HIST_HOURS 24              //Hourly aggregates kept before the current hour
+
+typedef struct{
+    INT32S min;                 //0.01C
+    INT32S max;
+    INT32S avg;
+    INT32U count;               //Samples, 0 if none in the range
+} TEMP_HIST_STATS;
+
+/********************************************************************
+* TempHistInit - Checks the history left in SRAM_L
+*
+* Description:  The history is not cleared by the startup code, so it
+*               survives a watchdog or debugger reset. It is only cleared if
+*               it is not valid, as at power up.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void TempHistInit(void);
+/********************************************************************
+* TempHistAdd - Adds one sample
+*
+* Description:  Meant to be called at TEMP_HIST_RATE_HZ. Updates the
+*               aggregate of the sample's hour and appends it to the
+*               compressed ring, dropping the oldest block when full.
+*
+* Return value: None
+*
+* Arguments:    Temperature in 0.01C, RTC seconds of the sample
+********************************************************************/
+void TempHistAdd(INT32S centi, INT32U time_s);
+/********************************************************************
+* TempHistRange - Min, max and average over a time range
+*
+* Description:  Hours wholly inside the range come from the hourly
+*               aggregates, the rest is decoded from the ring. Values
+*               decoded from the ring have 0.1C resolution.
+*
+* Return value: 1 if the range held any samples, else 0
+*
+* Arguments:    Range [from_s, to_s) in RTC seconds, where to put the result
+********************************************************************/
+INT8U TempHistRange(INT32U from_s, INT32U to_s, TEMP_HIST_STATS *stats);
+/********************************************************************
+* TempHistHour - Returns an hourly aggregate
+*
+* Return value: 1 if that hour held any samples, else 0
+*
+* Arguments:    Hours before the current one, 0 to TEMP_HIST_HOURS, where
+*               to put the result
+********************************************************************/
+INT8U TempHistHour(INT8U hours_ago, TEMP_HIST_STATS *stats);
+/********************************************************************
+* TempHistDump - Decodes the ring for offline analysis
+*
+* Description:  Calls emit once per stored sample from from_s on, oldest
+*               first. The time is in half seconds, RTC seconds*2 plus the
+*               sample's place within its second.
+*
+* Return value: None
+*
+* Arguments:    First RTC second wanted, function to call per sample
+********************************************************************/
+void TempHistDump(INT32U from_s, void (*emit)(INT32U time_h, INT32S centi));
+
+#endif /* SOURCES_TEMPHIST_H_ */
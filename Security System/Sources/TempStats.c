@@ -0,0 +1,220 @@
+/*******************************************************************************
+* TempStats.c - Rolling statistics of the last TEMP_STATS_WINDOW_S of
+*               temperature samples and a rate-of-rise alarm.
+*
+* Description: Each sample updates the window sums, the least squares sums
+*              and the min/max deques in constant time, nothing is
+*              recomputed over the window. Sample x positions are 0 for the
+*              oldest to n-1 for the newest, so when the oldest sample drops
+*              out every x moves down by one:
+*                  Sxy' = Sxy - (Sy - y_old) + (n-1)*y_new
+*              The min and max are kept with monotonic deques of sample
+*              numbers; the front is the answer and is dropped once it falls
+*              out of the window.
+*              The rate-of-rise alarm follows fixed heat detectors at
+*              8.3C/min (15F/min) and also needs the window to have risen
+*              TEMP_ROR_MIN_RISE_CENTI from its minimum, so sensor noise on
+*              a short fit can not set it. It clears at half the rate.
+*              Hardware free so it can be built on a host.
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#include "MCUType.h"
+#include "TempStats.h"
+
+#define TEMP_ROR_ALARM_CENTI_MIN 833    //8.33C/min
+#define TEMP_ROR_CLEAR_CENTI_MIN 416
+#define TEMP_ROR_MIN_RISE_CENTI 300     //Window rise needed as well
+#define TEMP_STATS_PER_MIN (TEMP_STATS_RATE_HZ*60)
+
+static INT32S statsWindow[TEMP_STATS_LEN];      //Indexed by sample number
+static INT32U statsSeq;                         //Number of the next sample
+static INT16U statsCount;
+static INT32S statsSumY;
+static INT32S statsSumXY;
+static INT32U statsMinQ[TEMP_STATS_LEN];        //Sample numbers, values rising
+static INT32U statsMaxQ[TEMP_STATS_LEN];        //Sample numbers, values falling
+static INT16U statsMinHead;
+static INT16U statsMinLen;
+static INT16U statsMaxHead;
+static INT16U statsMaxLen;
+static INT8U statsRateAlarm;
+
+static void statsDequePush(INT32U *queue, INT16U head, INT16U *len, INT32S value, INT8U keep_min);
+static void statsDequeExpire(const INT32U *queue, INT16U *head, INT16U *len);
+
+/********************************************************************
+* TempStatsAdd - Adds one sample to the rolling window
+*
+* Description:  Drops the oldest sample once the window is full, updates the
+*               sums and deques, then the rate-of-rise alarm.
+*
+* Return value: None
+*
+* Arguments:    Temperature in 0.01 C
+********************************************************************/
+void TempStatsAdd(INT32S centi){
+    INT32S slope;
+    INT32S y_old;
+
+    if(statsCount >= TEMP_STATS_LEN){
+        y_old = statsWindow[statsSeq % TEMP_STATS_LEN];
+        statsSumXY = statsSumXY - (statsSumY - y_old) + ((INT32S)(TEMP_STATS_LEN - 1)*centi);
+        statsSumY = statsSumY - y_old + centi;
+    } else{
+        statsSumXY += ((INT32S)statsCount*centi);
+        statsSumY += centi;
+        statsCount++;
+    }
+    statsWindow[statsSeq % TEMP_STATS_LEN] = centi;
+    statsDequeExpire(statsMinQ, &statsMinHead, &statsMinLen);
+    statsDequeExpire(statsMaxQ, &statsMaxHead, &statsMaxLen);
+    statsDequePush(statsMinQ, statsMinHead, &statsMinLen, centi, 1);
+    statsDequePush(statsMaxQ, statsMaxHead, &statsMaxLen, centi, 0);
+    statsSeq++;
+
+    slope = TempStatsSlope();
+    if((statsCount >= TEMP_STATS_LEN) && (slope >= TEMP_ROR_ALARM_CENTI_MIN) &&
+       ((centi - TempStatsMin()) >= TEMP_ROR_MIN_RISE_CENTI)){
+        statsRateAlarm = 1;
+    } else if(slope < TEMP_ROR_CLEAR_CENTI_MIN){
+        statsRateAlarm = 0;
+    } else{
+    }
+}
+/********************************************************************
+* TempStatsMean - Window mean
+*
+* Return value: Mean in 0.01 C, 0 if the window is empty
+*
+* Arguments:    None
+********************************************************************/
+INT32S TempStatsMean(void){
+    INT32S mean = 0;
+
+    if(statsCount != 0){
+        mean = statsSumY/(INT32S)statsCount;
+    } else{
+    }
+    return(mean);
+}
+/********************************************************************
+* TempStatsSlope - Least squares slope of the window
+*
+* Description:  (n*Sxy - Sx*Sy)/(n*Sxx - Sx^2) per sample, with Sx and Sxx
+*               in closed form for x = 0..n-1, scaled to per minute.
+*
+* Return value: Slope in 0.01 C per minute, 0 with under two samples
+*
+* Arguments:    None
+********************************************************************/
+INT32S TempStatsSlope(void){
+    INT64S n = statsCount;
+    INT64S sx;
+    INT64S sxx;
+    INT64S num;
+    INT64S den;
+    INT32S slope = 0;
+
+    if(n >= 2){
+        sx = (n*(n - 1))/2;
+        sxx = ((n - 1)*n*((2*n) - 1))/6;
+        num = (n*statsSumXY) - (sx*statsSumY);
+        den = (n*sxx) - (sx*sx);
+        slope = (INT32S)((num*TEMP_STATS_PER_MIN)/den);
+    } else{
+    }
+    return(slope);
+}
+/********************************************************************
+* TempStatsMin - Window minimum
+*
+* Return value: Minimum in 0.01 C, 0 if the window is empty
+*
+* Arguments:    None
+********************************************************************/
+INT32S TempStatsMin(void){
+    INT32S min = 0;
+
+    if(statsMinLen != 0){
+        min = statsWindow[statsMinQ[statsMinHead] % TEMP_STATS_LEN];
+    } else{
+    }
+    return(min);
+}
+/********************************************************************
+* TempStatsMax - Window maximum
+*
+* Return value: Maximum in 0.01 C, 0 if the window is empty
+*
+* Arguments:    None
+********************************************************************/
+INT32S TempStatsMax(void){
+    INT32S max = 0;
+
+    if(statsMaxLen != 0){
+        max = statsWindow[statsMaxQ[statsMaxHead] % TEMP_STATS_LEN];
+    } else{
+    }
+    return(max);
+}
+/********************************************************************
+* TempStatsRateAlarm - Returns the rate-of-rise alarm state
+*
+* Return value: 1 while the temperature is rising too fast, else 0
+*
+* Arguments:    None
+********************************************************************/
+INT8U TempStatsRateAlarm(void){
+    return(statsRateAlarm);
+}
+/********************************************************************
+* statsDequePush - Adds the newest sample to a min or max deque
+*
+* Description:  Samples at the back that can never be the answer again are
+*               dropped first: for the min deque those not under the new
+*               value, for the max deque those not over it. Each sample is
+*               pushed and dropped once, so this is constant time amortized.
+*
+* Return value: None
+*
+* Arguments:    Deque, its head and length, the new value, 1 for min
+********************************************************************/
+static void statsDequePush(INT32U *queue, INT16U head, INT16U *len, INT32S value, INT8U keep_min){
+    INT32S back;
+    INT8U drop = 1;
+
+    while((*len != 0) && (drop != 0)){
+        back = statsWindow[queue[(head + *len - 1) % TEMP_STATS_LEN] % TEMP_STATS_LEN];
+        if(keep_min != 0){
+            drop = (INT8U)(back >= value);
+        } else{
+            drop = (INT8U)(back <= value);
+        }
+        if(drop != 0){
+            (*len)--;
+        } else{
+        }
+    }
+    queue[(head + *len) % TEMP_STATS_LEN] = statsSeq;
+    (*len)++;
+}
+/********************************************************************
+* statsDequeExpire - Drops the front of a deque once out of the window
+*
+* Description:  Called before the new sample is pushed, so the sample it
+*               replaces in statsWindow is already gone and the deque never
+*               holds more than TEMP_STATS_LEN entries.
+*
+* Return value: None
+*
+* Arguments:    Deque, its head and length
+********************************************************************/
+static void statsDequeExpire(const INT32U *queue, INT16U *head, INT16U *len){
+    if((*len != 0) && ((statsSeq - queue[*head]) >= TEMP_STATS_LEN)){
+        *head = (INT16U)((*head + 1) % TEMP_STATS_LEN);
+        (*len)--;
+    } else{
+    }
+}
@@ -0,0 +1,66 @@
+/*******************************************************************************
+* TempStats.h - Project header file for TempStats.c
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#ifndef SOURCES_TEMPSTATS_H_
+#define SOURCES_TEMPSTATS_H_
+
+#define TEMP_STATS_RATE_HZ 2            //Samples per second added
+#define TEMP_STATS_WINDOW_S 60          //Window length
+#define TEMP_STATS_LEN (TEMP_STATS_RATE_HZ*TEMP_STATS_WINDOW_S)
+
+/********************************************************************
+* TempStatsAdd - Adds one sample to the rolling window
+*
+* Description:  Drops the oldest sample once the window is full. Every
+*               statistic is updated in constant time.
+*
+* Return value: None
+*
+* Arguments:    Temperature in 0.01 C
+********************************************************************/
+void TempStatsAdd(INT32S centi);
+/********************************************************************
+* TempStatsMean - Window mean
+*
+* Return value: Mean in 0.01 C, 0 if the window is empty
+*
+* Arguments:    None
+********************************************************************/
+INT32S TempStatsMean(void);
+/********************************************************************
+* TempStatsSlope - Least squares slope of the window
+*
+* Return value: Slope in 0.01 C per minute, 0 with under two samples
+*
+* Arguments:    None
+********************************************************************/
+INT32S TempStatsSlope(void);
+/********************************************************************
+* TempStatsMin - Window minimum
+*
+* Return value: Minimum in 0.01 C, 0 if the window is empty
+*
+* Arguments:    None
+********************************************************************/
+INT32S TempStatsMin(void);
+/********************************************************************
+* TempStatsMax - Window maximum
+*
+* Return value: Maximum in 0.01 C, 0 if the window is empty
+*
+* Arguments:    None
+********************************************************************/
+INT32S TempStatsMax(void);
+/********************************************************************
+* TempStatsRateAlarm - Returns the rate-of-rise alarm state
+*
+* Return value: 1 while the temperature is rising too fast, else 0
+*
+* Arguments:    None
+********************************************************************/
+INT8U TempStatsRateAlarm(void);
+
+#endif /* SOURCES_TEMPSTATS_H_ */
@@ -2,12 +2,20 @@
 *   Cooperative Multitasking Security System
 *   This program uses a timeslice scheduler to create an alarm system. This
 *   alarm has an ARMED, DISARMED, and ALARM state (ALARM and TEMP ALARM). If
-*   tampering is detected the tampering alarm "TP" will show. If the program
+*   tampering (a change in orientation, or vibration) is detected the
+*   tampering alarm "TP" will show. If the program
 *   hangs for longer than 11ms a watchdog "WD" will show. If the temperature is
 *   below 0c or above 40c not in DISARMED mode the alarm will show TEMP ALARM.
-*   ALARM mode is also reached if either of the two touch sensors are activated.
+*   ALARM mode is also reached if either of the two touch sensors is held or
+*   a finger slides across them, a brief brush-past is ignored. After a
+*   while ARMED with nothing happening the board sleeps in LLS until a hand
+*   approaches the touch pads, waking every few seconds to check the
+*   temperature.
 *   When in ALARM mode, an alarm noise will be played, via DMA to DAC. A real
-*   time clock is displayed.
+*   time clock is displayed. A # press while DISARMED plays a short tone and
+*   checks it at the DAC output, showing SOUND OK or SOUND FAIL. A digit
+*   sets the alarm volume in tens of percent, 0 being full, and a * shows
+*   the longest sound buffer refill so far in microseconds.
 *
 * Created on: 11/27/2017
 * Author: Anthony Needles
@@ -19,10 +27,16 @@
 #include "Key.h"
 #include "SysTickDelay.h"
 #include "TSI.h"
+#include "TSIGesture.h"
 #include "TempADC.h"
+#include "TempHist.h"
 #include "MMA8451Q.h"
+#include "ADPCM.h"
+#include "AlarmChime.h"
 #include "DMA.h"
+#include "AudioTest.h"
 #include "WDog.h"
+#include "LowPower.h"
 
 #define SLICE_PERIOD 10
 #define RTC_OFFSET 43474    //Must be reset anytime battery is removed
@@ -30,16 +44,27 @@
 #define B_PRESS 0x12
 #define C_PRESS 0x13
 #define D_PRESS 0x14
+#define HASH_PRESS '#'
+#define STAR_PRESS '*'
+#define CYCLES_PER_US 180               //Core clock, DMARefillCycles() to us
+#define SLEEP_IDLE_SLICES 3000  //30s idle in ARMED before sleeping
+#define SLEEP_AWAKE_SLICES 100  //Awake time after a timed wakeup, 2 temp samples
+#define SLEEP_MAX_S 5           //Longest sleep without a wakeup
+#define VIB_TAMPER_COUNTS 410   //0.1g, sum of the axis deviations in a batch
 
 typedef enum{DISARMED, ARMED, ALARM} ALARMSTATE;
 
 void ControlDisplayTask(void);
 void AlarmControlTask(void);
 void LEDTask(void);
+void TempAlarmTask(void);
 void TempDisplayTask(void);
+void TempLogTask(void);
 void AccelDisplayTask(void);
+void AccelVibrationTask(void);
 void RTCDisplayTask(void);
 void WDogResetCheck(void);
+void SleepTask(void);
 
 const INT8C DisarmedPrompt[] = "DISARMED";
 const INT8C ArmedPrompt[] = "ARMED";
@@ -47,12 +72,16 @@ const INT8C AlarmPrompt[] = "ALARM";
 const INT8C TempAlarmPrompt[] = "TEMP ALARM";
 const INT8C WDResetPrompt[] = "WD";
 const INT8C TamperingPrompt[] = "TP";
+const INT8C SoundOkPrompt[] = "SOUND OK";
+const INT8C SoundFailPrompt[] = "SOUND FAIL";
+const INT8C RefillPrompt[] = "DMA us";
 const INT8C ClearTwoSpaces[] = "  ";
 const INT8C ClearTenSpaces[] = "          ";
 
 static ALARMSTATE AlarmState = ARMED;
 static INT8U TempUnitSelect = 0;
 static INT8U TempAlarm = 0;
+static INT16U IdleSlices = 0;
 
 void main(void){
     GpioDBugBitsInit();
@@ -66,9 +95,12 @@ void main(void){
     TSIInit();
     TempADCInit();
     TempADCPIT1Init();
+    TempHistInit();
     I2CInit();
     MMA8451PLInit();
+    MMA8451FIFOInit();
     DMAInit();
+    LowPowerInit();
     WDogResetCheck();
     WDogInit();
 
@@ -76,12 +108,20 @@ void main(void){
         SysTickWaitEvent(SLICE_PERIOD);
         WDogTask();
         ControlDisplayTask();
+        TempADCTask();
+        TempAlarmTask();
         TempDisplayTask();
+        TempLogTask();
+        AudioTestTask();
         KeyTask();
         TSITask();
+        TSIGestureTask();
         LEDTask();
         AccelDisplayTask();
+        MMA8451FIFOTask();
+        AccelVibrationTask();
         RTCDisplayTask();
+        SleepTask();
     }
 }
 /********************************************************************
@@ -93,11 +133,17 @@ void main(void){
 *               If a B is pressed, the temperature select is changed. If a C is
 *               displayed, the tampering alarm is cleared. When in DISARMED mode,
 *               if an A is pressed the alarm goes to ARMED. When in ARMED mode,
-*               if the touch sensors are active or the temperature went out of
-*               bounds, the program will enter ALARM state. If the temperature
-*               alarm was triggered, TEMP ALARM will be displayed, else the
-*               standard ALARM will be displayed. A D press will exit ALARM to
-*               DISARMED state.
+*               if a touch sensor is held, a slide across the sensors is seen,
+*               or the temperature went out of bounds, the program will enter
+*               ALARM state. A tap is taken as a brush-past and ignored. If the temperature
+*               alarm was triggered, TEMP ALARM will be displayed with the
+*               temporal-3 cadence, else the standard ALARM will be displayed
+*               with the AlarmChime clip and then a siren. A D press will exit ALARM to
+*               DISARMED state. A # press in DISARMED starts the sound
+*               self-test, see AudioTest.c, which owns the sound until its
+*               result is displayed, so ARMED cannot be entered meanwhile.
+*               A digit in DISARMED sets the alarm volume, a * displays the
+*               worst DMA refill time.
 *               This task runs once every [2*SLICE_PERIOD] = 20ms.
 *
 *
@@ -109,17 +155,21 @@ void ControlDisplayTask(void){
     static INT8U cdt_slice_counter = 1;
     static ALARMSTATE last_state = DISARMED;
     INT8C button_press;
+    static INT32U last_test_seq = 0;
     ALARMSTATE cur_state;
-    INT8U electrode1_flag;
-    INT8U electrode2_flag;
+    TSI_GESTURE gesture;
+    AUDIO_TEST_RESULT sound_test;
 
     DB1_TURN_ON();
     if(cdt_slice_counter > 0){
         cdt_slice_counter = 0;
         button_press = GetKey();
-        electrode1_flag = TSIGetSensor(E1FLAG);
-        electrode2_flag = TSIGetSensor(E2FLAG);
+        gesture = TSIGestureGet();
         cur_state = AlarmState;
+        if((button_press != 0)||(gesture != TSI_GEST_NONE)||(cur_state != last_state)){
+            IdleSlices = 0;
+        } else{
+        }
         switch(button_press){
             case(B_PRESS):
                 TempUnitSelect = ~TempUnitSelect;
@@ -133,7 +183,10 @@ void ControlDisplayTask(void){
         }
         switch (cur_state){
             case(DISARMED):
-                PIT_TCTRL0 &= PIT_TCTRL_TEN(0);
+                if(AudioTestBusy() == 0){
+                    DMAAlarmOff();
+                } else{
+                }
                 if(last_state != cur_state){
                     LcdMoveCursor(2,1);
                     LcdDispStrg(ClearTenSpaces);
@@ -141,16 +194,48 @@ void ControlDisplayTask(void){
                     LcdDispStrg(DisarmedPrompt);
                 } else{
                 }
+                AudioTestGetResult(&sound_test);
+                if(sound_test.seq != last_test_seq){
+                    last_test_seq = sound_test.seq;
+                    LcdMoveCursor(2,1);
+                    LcdDispStrg(ClearTenSpaces);
+                    LcdMoveCursor(2,1);
+                    if(sound_test.status == AUDIO_TEST_PASS){
+                        LcdDispStrg(SoundOkPrompt);
+                    } else{
+                        LcdDispStrg(SoundFailPrompt);
+                    }
+                } else{
+                }
                 switch(button_press){
                     case(A_PRESS):
-                        AlarmState = ARMED;
+                        if(AudioTestBusy() == 0){
+                            AlarmState = ARMED;
+                        } else{
+                        }
+                        break;
+                    case(HASH_PRESS):
+                        AudioTestStart();
+                        break;
+                    case(STAR_PRESS):
+                        LcdMoveCursor(2,1);
+                        LcdDispStrg(ClearTenSpaces);
+                        LcdMoveCursor(2,1);
+                        LcdDispStrg(RefillPrompt);
+                        LcdDispDecWord(DMARefillCycles()/CYCLES_PER_US, 4); //Fits ten
                         break;
                     default:
+                        if((button_press >= '1') && (button_press <= '9')){
+                            DMASetVolume((INT8U)((button_press - '0')*10));
+                        } else if(button_press == '0'){
+                            DMASetVolume(100);
+                        } else{
+                        }
                         break;
                 }
                 break;
             case(ARMED):
-                PIT_TCTRL0 &= PIT_TCTRL_TEN(0);
+                DMAAlarmOff();
                 if(last_state != cur_state){
                     LcdMoveCursor(2,1);
                     LcdDispStrg(ClearTenSpaces);
@@ -158,7 +243,8 @@ void ControlDisplayTask(void){
                     LcdDispStrg(ArmedPrompt);
                 } else{
                 }
-                if((electrode1_flag == 0x1)||(electrode2_flag == 0x1)||(TempAlarm == 1)){
+                if((gesture == TSI_GEST_HOLD)||(gesture == TSI_GEST_SLIDE_FWD)||
+                   (gesture == TSI_GEST_SLIDE_BACK)||(TempAlarm == 1)){
                     AlarmState = ALARM;
                 } else{
                 }
@@ -171,15 +257,19 @@ void ControlDisplayTask(void){
                 }
                 break;
             case(ALARM):
-                PIT_TCTRL0 |= PIT_TCTRL_TEN(1);
+                DMAAlarmOn();
                 if(last_state!= cur_state){
                     LcdMoveCursor(2,1);
                     LcdDispStrg(ClearTenSpaces);
                     LcdMoveCursor(2,1);
                     if(TempAlarm == 1){
                         LcdDispStrg(TempAlarmPrompt);
+                        DMAPlayCadence(DMA_CADENCE_TEMPORAL3);
                     } else{
                         LcdDispStrg(AlarmPrompt);
+                        DMAStopCadence();
+                        DMASetSound(DMA_SOUND_SIREN);
+                        DMAPlayClip(&AlarmChime);
                     }
                 } else{
                 }
@@ -219,14 +309,16 @@ void LEDTask(void){
     static INT8U ledt_enter_counter = 5;
     static INT8U ledt_toggle_counter = 0;
     static INT8U latched_sensor_states;
+    INT32U sensors;
     INT8U electrode1_flag;
     INT8U electrode2_flag;
 
     DB4_TURN_ON();
     if(ledt_slice_counter > 3){
         ledt_slice_counter = 0;
-        electrode1_flag = TSIGetSensor(E1FLAG);
-        electrode2_flag = TSIGetSensor(E2FLAG);
+        sensors = TSIGetSensors();
+        electrode1_flag = ((sensors & TSI_E1_MASK) != 0);
+        electrode2_flag = ((sensors & TSI_E2_MASK) != 0);
         switch(AlarmState){
             case(ALARM):
                 if(electrode1_flag == 1){
@@ -323,32 +415,65 @@ void LEDTask(void){
     DB4_TURN_OFF();
 }
 /********************************************************************
+* TempAlarmTask - Follows the temperature alarm
+*
+* Description:  TempAlarm is set while the published sample has either the
+*               hardware compare alarm (<0c or >40c) or the rate-of-rise
+*               alarm. Both are decided in 0.01C by TempADC.c, so the
+*               display unit has no effect on them.
+*               This task runs every slice.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void TempAlarmTask(void){
+    TEMP_SAMPLE sample;
+
+    TempADCGetSample(&sample);
+    if(sample.alarm != 0){
+        TempAlarm = 1;
+    } else{
+        TempAlarm = 0;
+    }
+}
+/********************************************************************
 * TempDisplayTask - Handles display of current detected temperature
 *
 * Description:  A task that will show the current temperature to the LCD.
-*               The value will be fetched from "GetTemp". Supports negative
-*               values. Sets TempAlarm flag if the ALARM should be set based
-*               off of the current temperature (<0c or >40c). This task
-*               runs once every time ADC_SC1_COCO_MASK is set, which is
-*               the set period of PIT1.
-*               This task runs once every 500ms.
+*               The value is the published sample from TempADCGetSample(),
+*               converted to the selected unit. Supports negative values.
+*               A '?' replaces the degree sign while the sample reports a
+*               calibration or sensor fault. The display runs once for every
+*               new sample, every 500ms, see TempADC.c, and right away when
+*               the unit is changed.
 *
 * Return value: None
 *
 * Arguments:    None
 ********************************************************************/
 void TempDisplayTask(void){
+    static INT32U last_seq = 0;
+    static INT8U last_unit = 0;
+    TEMP_SAMPLE sample;
     INT32S temperature;
-    INT8U negative_temp_flag = 0;
+    INT8C degree_char;
 
     DB6_TURN_ON();
-    if((ADC0_SC1A & ADC_SC1_COCO_MASK) != 0){        //Via configuration of PIT1
-        temperature = LowADCPull(TempUnitSelect);//this will enter every 500ms
+    TempADCGetSample(&sample);
+    if((sample.seq != last_seq) || (TempUnitSelect != last_unit)){
+        last_seq = sample.seq;
+        last_unit = TempUnitSelect;
+        temperature = TempCentiToUnit(sample.centi, TempUnitSelect);
+        if(sample.fault != 0){
+            degree_char = '?';
+        } else{
+            degree_char = (INT8C)0xDF;
+        }
         if(temperature < 0){
             LcdMoveCursor(1,1);
             LcdDispChar('-');
             temperature = (~temperature + 1);
-            negative_temp_flag = 1;
         } else{
             LcdMoveCursor(1,1);
             LcdDispChar(' ');
@@ -358,27 +483,17 @@ void TempDisplayTask(void){
                 LcdMoveCursor(1,2);
                 LcdDispDecByte((INT8U)temperature, 0);
                 LcdMoveCursor(1,5);
-                LcdDispChar(0xDF);
+                LcdDispChar(degree_char);
                 LcdMoveCursor(1,6);
                 LcdDispChar('C');
-                if((negative_temp_flag == 1)||(temperature > 40)){
-                    TempAlarm = 1;
-                } else{
-                    TempAlarm = 0;
-                }
                 break;
             case(0xFF):
                 LcdMoveCursor(1,2);
                 LcdDispDecByte((INT8U)temperature, 0);
                 LcdMoveCursor(1,5);
-                LcdDispChar(0xDF);
+                LcdDispChar(degree_char);
                 LcdMoveCursor(1,6);
                 LcdDispChar('F');
-                if((temperature < 32)||(temperature > 104)){
-                    TempAlarm = 1;
-                } else{
-                    TempAlarm = 0;
-                }
                 break;
             default:
                 break;
@@ -388,11 +503,35 @@ void TempDisplayTask(void){
     DB6_TURN_OFF();
 }
 /********************************************************************
+* TempLogTask - Adds each published temperature sample to the history
+*
+* Description:  Samples are stamped with RTC_TSR, which keeps counting
+*               through low power sleep, see TempHist.c.
+*               This task runs once every 500ms.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void TempLogTask(void){
+    static INT32U last_seq = 0;
+    TEMP_SAMPLE sample;
+
+    TempADCGetSample(&sample);
+    if(sample.seq != last_seq){
+        last_seq = sample.seq;
+        TempHistAdd(sample.centi, RTC_TSR);
+    } else{
+    }
+}
+/********************************************************************
 * AccelDisplayTask - Handles display of tampering display
 *
 * Description:  A task that checks whether the status flag for a change in
 *               orientation from the accelerometer was set. A tampering display
-*               will be shown if the flag was set. Note an extra volatile
+*               will be shown if the flag was set. The read is queued on the
+*               I2C engine and the value used is the one read by the
+*               previous run, so the task never waits on the bus. Note an extra volatile
 *               variable who's purpose is only to ignore the first status flag
 *               read. This results from an unknown bug where the status flag
 *               is not cleared following the first write (as it should).
@@ -405,18 +544,27 @@ void TempDisplayTask(void){
 void AccelDisplayTask(void){
     static INT16U at_slice_counter = 4;
     static INT8U first_time_run = 1; //This variable is needed for a bug, see above
+    static I2C_XFER pl_xfer;
+    static INT8U pl_status;
     INT8U lp_check;
 
     DB7_TURN_ON();
     if(at_slice_counter > 3){
         at_slice_counter = 0;
-        lp_check = (MMA8451RegRd(MMA8451_PL_STATUS)&0x80); //Bit 7 corresponds
-        lp_check = lp_check >> 7;                          //to status change
-        if((lp_check == 1)&&(first_time_run == 0)){
-            LcdMoveCursor(2,12);
-            LcdDispStrg(TamperingPrompt);
+        if(pl_xfer.status == I2C_XFER_DONE){
+            lp_check = (pl_status&0x80);   //Bit 7 corresponds
+            lp_check = lp_check >> 7;      //to status change
+            if((lp_check == 1)&&(first_time_run == 0)){
+                LcdMoveCursor(2,12);
+                LcdDispStrg(TamperingPrompt);
+            } else{
+                first_time_run = 0;
+            }
+        } else{
+        }
+        if((pl_xfer.status != I2C_XFER_QUEUED)&&(pl_xfer.status != I2C_XFER_BUSY)){
+            MMA8451RegRdQueue(&pl_xfer, MMA8451_PL_STATUS, &pl_status, 0);
         } else{
-            first_time_run = 0;
         }
     } else{
         at_slice_counter++;
@@ -424,6 +572,66 @@ void AccelDisplayTask(void){
     DB7_TURN_OFF();
 }
 /********************************************************************
+* AccelVibrationTask - Shows the tampering display on vibration
+*
+* Description:  Each accelerometer FIFO batch, up to MMA8451_FIFO_WMRK
+*               samples at MMA8451_FIFO_HZ, is checked once when it arrives.
+*               Only the MMA8451BatchCount() samples that were in the FIFO
+*               are used, a batch with fewer than 2 is skipped. The
+*               deviation of a sample is the sum over the axes of its
+*               distance from the batch mean, so gravity and a tilted
+*               board cancel, and the largest deviation over
+*               VIB_TAMPER_COUNTS shows the tampering display.
+*               This task runs every slice, a batch every 100ms.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void AccelVibrationTask(void){
+    static INT32U last_seq = 0;
+    const MMA8451_BATCH *batch;
+    MMA8451_XYZ xyz;
+    INT32U seq;
+    INT32S sum[3] = {0, 0, 0};
+    INT32S mean[3];
+    INT32S dev;
+    INT32S peak = 0;
+    INT8U count;
+    INT8U i;
+
+    batch = MMA8451FIFOGet(&seq);
+    if((batch != 0) && (seq != last_seq)){
+        last_seq = seq;
+        count = MMA8451BatchCount(batch);
+        for(i = 0; i < count; i++){
+            MMA8451BatchXYZ(batch, i, &xyz);
+            sum[0] += xyz.x;
+            sum[1] += xyz.y;
+            sum[2] += xyz.z;
+        }
+        for(i = 0; i < 3; i++){
+            mean[i] = (count != 0) ? (sum[i]/count) : 0;
+        }
+        for(i = 0; i < count; i++){
+            MMA8451BatchXYZ(batch, i, &xyz);
+            dev = ((xyz.x > mean[0]) ? (xyz.x - mean[0]) : (mean[0] - xyz.x)) +
+                  ((xyz.y > mean[1]) ? (xyz.y - mean[1]) : (mean[1] - xyz.y)) +
+                  ((xyz.z > mean[2]) ? (xyz.z - mean[2]) : (mean[2] - xyz.z));
+            if(dev > peak){
+                peak = dev;
+            } else{
+            }
+        }
+        if((count > 1) && (peak > VIB_TAMPER_COUNTS)){
+            LcdMoveCursor(2,12);
+            LcdDispStrg(TamperingPrompt);
+        } else{
+        }
+    } else{
+    }
+}
+/********************************************************************
 * RTCDisplayTask - Displays current time 24h clock based off of on board RTC.
 *
 * Description:  This task will pull the current RTC count value (counting at
@@ -481,3 +689,41 @@ void WDogResetCheck(void){
     } else{
     }
 }
+/********************************************************************
+* SleepTask - Sleeps between events while ARMED
+*
+* Description:  Counts slices with no key, gesture, touch or state change.
+*               Once ARMED has been idle for SLEEP_IDLE_SLICES with no
+*               temperature alarm, the touch sensor is switched to
+*               proximity mode and the board sleeps in LLS. An approach
+*               wakes it within one proximity scan period and restarts the
+*               idle count. Otherwise the RTC alarm wakes it after
+*               SLEEP_MAX_S and it stays awake for SLEEP_AWAKE_SLICES so
+*               the temperature and keypad are checked, then sleeps again.
+*               Sleep waits for any I2C transaction to finish.
+*               Runs every slice.
+*
+* Return value: None
+*
+* Arguments:    None
+********************************************************************/
+void SleepTask(void){
+    if(TSIGetSensors() != 0){
+        IdleSlices = 0;
+    } else{
+    }
+    if((AlarmState == ARMED) && (TempAlarm == 0) && (IdleSlices >= SLEEP_IDLE_SLICES) &&
+       (I2CBusy() == 0)){
+        TSIProxEnter();
+        LowPowerSleep(SLEEP_MAX_S);
+        TSIProxExit();
+        if(TSIGetProximity() != 0){
+            IdleSlices = 0;
+        } else{
+            IdleSlices = (SLEEP_IDLE_SLICES - SLEEP_AWAKE_SLICES);
+        }
+    } else if(IdleSlices < SLEEP_IDLE_SLICES){
+        IdleSlices++;
+    } else{
+    }
+}
@@ -0,0 +1,141 @@
+/*******************************************************************************
+* adpcm_encode.c - Host tool that encodes a clip for ADPCM.c
+*
+* Description: Reads 16 bit little endian mono PCM and writes a C source file
+*              with the IMA ADPCM codes and an ADPCM_CLIP named by the
+*              second argument. Each code is the one of the 16 that makes
+*              ADPCMDecode() land closest to the input, so the prediction is
+*              the firmware decoder itself. The output is then decoded
+*              again from the clip start state and compared sample for
+*              sample with that prediction; the tool fails on any
+*              difference and reports the SNR against the input. That only
+*              shows the clip matches ADPCMDecode(), adpcm_test.c checks
+*              ADPCMDecode() itself against an independent decoder.
+*
+*              Build: gcc -I../Sources -I../CMSIS -o adpcm_encode
+*                         adpcm_encode.c ../Sources/ADPCM.c -lm
+*              Use:   adpcm_encode rate_hz Name < clip.raw > ../Sources/Name.c
+*              AlarmChime.c is made from the PCM written by chime_pcm.c.
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "MCUType.h"
+#include "ADPCM.h"
+
+#define ENC_MAX_SAMPLES 262144
+#define ENC_PER_LINE 12
+
+static INT16S encPCM[ENC_MAX_SAMPLES];
+static INT16S encRecon[ENC_MAX_SAMPLES];
+static INT8U encCodes[ENC_MAX_SAMPLES];
+
+static INT8U encBestCode(ADPCM_STATE *state, INT16S target, INT16S *out);
+
+int main(int argc, char **argv){
+    ADPCM_STATE state;
+    ADPCM_STATE start;
+    unsigned char raw[2];
+    double sig = 0.0;
+    double err = 0.0;
+    long rate;
+    long n = 0;
+    long i;
+
+    if(argc != 3){
+        fprintf(stderr, "usage: adpcm_encode rate_hz Name < clip.raw > Name.c\n");
+        return(2);
+    } else{
+    }
+    rate = strtol(argv[1], 0, 10);
+    while((n < ENC_MAX_SAMPLES) && (fread(raw, 1, 2, stdin) == 2)){
+        encPCM[n++] = (INT16S)(raw[0] | (raw[1] << 8));
+    }
+    if(n == 0){
+        fprintf(stderr, "adpcm_encode: no samples\n");
+        return(1);
+    } else{
+    }
+    if((n & 1) != 0){
+        encPCM[n] = encPCM[n - 1];          //Pad to whole bytes
+        n++;
+    } else{
+    }
+
+    start.predictor = encPCM[0];
+    start.index = 0;
+    state = start;
+    for(i = 0; i < n; i++){
+        encCodes[i] = encBestCode(&state, encPCM[i], &encRecon[i]);
+    }
+
+    state = start;
+    for(i = 0; i < n; i++){
+        if(ADPCMDecode(&state, encCodes[i]) != encRecon[i]){
+            fprintf(stderr, "adpcm_encode: decode mismatch at sample %ld\n", i);
+            return(1);
+        } else{
+        }
+        sig += (double)encPCM[i]*encPCM[i];
+        err += (double)(encPCM[i] - encRecon[i])*(encPCM[i] - encRecon[i]);
+    }
+    fprintf(stderr, "adpcm_encode: %ld samples, %ld bytes, SNR %.1f dB, decode bit exact\n",
+            n, n/2, 10.0*log10(sig/((err > 0.0) ? err : 1.0)));
+
+    printf("/*******************************************************************************\n");
+    printf("* %s.c - ADPCM clip, generated by Tools/adpcm_encode.c, do not edit\n", argv[2]);
+    printf("*******************************************************************************/\n");
+    printf("#include \"MCUType.h\"\n#include \"ADPCM.h\"\n\n");
+    printf("static const INT8U %sData[%ld] = {", argv[2], n/2);
+    for(i = 0; i < n; i += 2){
+        if(i != 0){
+            printf(",");
+        } else{
+        }
+        if(((i/2) % ENC_PER_LINE) == 0){
+            printf("\n    ");
+        } else{
+            printf(" ");
+        }
+        printf("0x%02X", encCodes[i] | (encCodes[i + 1] << 4));
+    }
+    printf("\n};\n\n");
+    printf("const ADPCM_CLIP %s = {%sData, %ldu, %ldu, {%d, %d}};\n",
+           argv[2], argv[2], n, rate, start.predictor, start.index);
+    return(0);
+}
+
+/********************************************************************
+* encBestCode - Picks the code that decodes closest to the target
+*
+* Return value: The code, the state is advanced by it
+*
+* Arguments:    Decoder state, input sample, where to put the decoded value
+********************************************************************/
+static INT8U encBestCode(ADPCM_STATE *state, INT16S target, INT16S *out){
+    ADPCM_STATE trial;
+    ADPCM_STATE best_state = *state;
+    INT16S value;
+    long best_err = -1;
+    long e;
+    INT8U best = 0;
+    INT8U code;
+
+    for(code = 0; code < 16; code++){
+        trial = *state;
+        value = ADPCMDecode(&trial, code);
+        e = labs((long)value - target);
+        if((best_err < 0) || (e < best_err)){
+            best_err = e;
+            best = code;
+            best_state = trial;
+            *out = value;
+        } else{
+        }
+    }
+    *state = best_state;
+    return(best);
+}
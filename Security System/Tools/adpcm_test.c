@@ -0,0 +1,91 @@
+/*******************************************************************************
+* adpcm_test.c - Host check of ADPCMDecode() against reference vectors
+*
+* Description: The expected samples were made by a separate IMA/DVI
+*              decoder, Python's audioop.adpcm2lin(), not by ADPCM.c or
+*              adpcm_encode.c, so an error shared by the encoder and the
+*              firmware decoder shows up here. The vectors cover every
+*              code up and down, the step index and sample clamps at both
+*              ends, and a pseudo-random run from a mid table state. Prints
+*              the first difference and fails, or passes silently.
+*
+*              Build: gcc -I../Sources -I../CMSIS -o adpcm_test
+*                         adpcm_test.c ../Sources/ADPCM.c
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#include <stdio.h>
+#include "MCUType.h"
+#include "ADPCM.h"
+
+#define TEST_MAX_CODES 32
+
+typedef struct{
+    const char *name;
+    ADPCM_STATE start;
+    INT8U n;
+    INT8U codes[TEST_MAX_CODES];
+    INT16S out[TEST_MAX_CODES];
+    ADPCM_STATE end;
+} TEST_VECTOR;
+
+static const TEST_VECTOR testVectors[] = {
+    {"ramp", {0, 0}, 32,
+     {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+      15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0},
+     {0, 1, 4, 8, 15, 27, 47, 88, 82, 66, 41, 10, -28, -84, -181, -380,
+      -810, -1612, -2816, -4258, -5616, -6497, -6977, -7122, -5135, -1443, 4092, 10722,
+      16962, 21014, 23223, 23892},
+     {23892, 68}},
+    {"up", {0, 0}, 16,
+     {7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7},
+     {11, 41, 104, 240, 533, 1164, 2521, 5431, 11667, 25039, 32767, 32767,
+      32767, 32767, 32767, 32767},
+     {32767, 88}},
+    {"down", {0, 0}, 16,
+     {15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15},
+     {-11, -41, -104, -240, -533, -1164, -2521, -5431, -11667, -25039, -32768, -32768,
+      -32768, -32768, -32768, -32768},
+     {-32768, 88}},
+    {"random", {1000, 40}, 32,
+     {12, 4, 5, 10, 15, 13, 13, 10, 10, 5, 12, 11, 14, 15, 3, 0,
+      9, 12, 13, 0, 15, 9, 15, 0, 13, 4, 12, 4, 13, 2, 11, 6},
+     {621, 1080, 1758, 1306, 73, -1866, -4706, -6596, -8313, -4878, -8995, -12869,
+      -19411, -32768, -19391, -17654, -22391, -32768, -32768, -30225, -32768, -32768, -32768, -28673,
+      -32768, 4094, -32768, 4094, -32768, -12290, -32768, 11246},
+     {11246, 88}},
+    {"top", {32000, 88}, 8,
+     {0, 8, 7, 7, 15, 15, 3, 11},
+     {32767, 29043, 32767, 32767, -28669, -32768, -4099, -30168},
+     {-30168, 86}}
+};
+
+int main(void){
+    const TEST_VECTOR *v;
+    ADPCM_STATE state;
+    INT16S sample;
+    unsigned int t;
+    INT8U i;
+
+    for(t = 0; t < (sizeof(testVectors)/sizeof(testVectors[0])); t++){
+        v = &testVectors[t];
+        state = v->start;
+        for(i = 0; i < v->n; i++){
+            sample = ADPCMDecode(&state, v->codes[i]);
+            if(sample != v->out[i]){
+                printf("adpcm_test: %s code %u: got %d, expected %d\n",
+                       v->name, i, sample, v->out[i]);
+                return(1);
+            } else{
+            }
+        }
+        if((state.predictor != v->end.predictor) || (state.index != v->end.index)){
+            printf("adpcm_test: %s end state {%d, %u}, expected {%d, %u}\n",
+                   v->name, state.predictor, state.index, v->end.predictor, v->end.index);
+            return(1);
+        } else{
+        }
+    }
+    return(0);
+}
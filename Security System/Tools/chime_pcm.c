@@ -0,0 +1,57 @@
+/*******************************************************************************
+* chime_pcm.c - Host tool that writes the source PCM of AlarmChime
+*
+* Description: Two notes, 784Hz for 0.35s then 622Hz for 0.45s, each a
+*              fundamental with 2nd and 3rd harmonics under an exponential
+*              decay and a 2.5ms attack, at 9.6kHz, 0.6 of full scale.
+*              Writes 16 bit little endian mono PCM for adpcm_encode.c.
+*
+*              Build: gcc -o chime_pcm chime_pcm.c -lm
+*              Use:   chime_pcm | adpcm_encode 9600 AlarmChime
+*                         > ../Sources/AlarmChime.c
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#include <stdio.h>
+#include <math.h>
+
+#define CHIME_FS_HZ 9600.0
+#define CHIME_NOTES 2
+#define CHIME_PI 3.141592653589793
+
+static const double chimeHz[CHIME_NOTES] = {784.0, 622.0};
+static const double chimeSec[CHIME_NOTES] = {0.35, 0.45};
+
+int main(void){
+    double t;
+    double env;
+    double v;
+    double f;
+    short s;
+    int note;
+    int n;
+    int i;
+
+    for(note = 0; note < CHIME_NOTES; note++){
+        f = chimeHz[note];
+        n = (int)(CHIME_FS_HZ*chimeSec[note]);
+        for(i = 0; i < n; i++){
+            t = i/CHIME_FS_HZ;
+            env = exp(-t*6.0)*fmin(1.0, t*400.0);
+            v = sin(2.0*CHIME_PI*f*t) + 0.4*sin(2.0*CHIME_PI*2.0*f*t) +
+                0.2*sin(2.0*CHIME_PI*3.0*f*t)*exp(-t*10.0);
+            v = v*env*0.6*32767.0/1.6;
+            if(v > 32767.0){
+                v = 32767.0;
+            } else if(v < -32767.0){
+                v = -32767.0;
+            } else{
+            }
+            s = (short)v;
+            putchar(s & 0xff);
+            putchar((s >> 8) & 0xff);
+        }
+    }
+    return(0);
+}
@@ -0,0 +1,164 @@
+/*******************************************************************************
+* goertzel_test.c - Host check of Goertzel.c with synthetic signals
+*
+* Description: Uses the block and bins of AudioTest.c, n = 480 and the
+*              first five harmonics of bin 30, with coefficients built the
+*              same way. Checks that
+*                  a pure tone on each bin reads its amplitude on that bin
+*                  and about zero on the others,
+*                  a mix of all five with DC and noise reads each one,
+*                  a full scale tone keeps the states in 32 bits,
+*                  a block given in several calls reads as in one.
+*              INT32S is 64 bits on an LP64 host, so the state range is
+*              checked against the target's 32 bits rather than left to
+*              wrap. Prints one line per check and fails if any is out.
+*
+*              Build: gcc -I../Sources -I../CMSIS -o goertzel_test
+*                         goertzel_test.c ../Sources/Goertzel.c -lm
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "MCUType.h"
+#include "DMAWave.h"
+#include "Goertzel.h"
+
+#define TEST_N 480                      //AUDIO_TEST_N
+#define TEST_BIN 30                     //AUDIO_TEST_BIN, 300Hz at 4800Hz
+#define TEST_BINS 5
+#define TEST_PI 3.141592653589793
+#define TEST_ON_TOL(a) (2 + (a)/500)    //On bin, 0.2% plus rounding
+#define TEST_OFF_TOL 3                  //Off bin leakage, input units
+#define TEST_MIX_TOL(a) (16 + (a)/100)  //With DC and +-100 of noise
+#define TEST_NOISE 100
+#define TEST_DC 700
+#define TEST_STATE_MAX 0x7FFFFFFFL      //INT32S on the target
+
+/* As AUDIO_TEST_COEFF() in AudioTest.c */
+#define TEST_COS(k) DMA_WAVE_SIN(1, (k) + (TEST_N/4), TEST_N)
+#define TEST_COEFF(h) ((INT32S)((2.0*(1 << GOERTZEL_Q)*TEST_COS((h)*TEST_BIN)) + \
+                       ((TEST_COS((h)*TEST_BIN) < 0.0) ? -0.5 : 0.5)))
+
+static const INT32S testCoeff[TEST_BINS] = {
+    TEST_COEFF(1), TEST_COEFF(2), TEST_COEFF(3), TEST_COEFF(4), TEST_COEFF(5)
+};
+/* The shape of the alarm tone, one harmonic left out */
+static const double testMixAmp[TEST_BINS] = {6550.0, 3000.0, 1000.0, 0.0, 12000.0};
+
+static INT16S testBuf[TEST_N];
+static INT32U testSeed = 1;
+
+static INT32U testRun(INT8U bin, INT16U split);
+static INT8U testCheck(const char *name, INT8U bin, INT32U got, INT32U expect, INT32U tol);
+static INT32S testNoise(void);
+
+int main(void){
+    INT8U fails = 0;
+    INT32U amp;
+    INT32S s1_max = 0;
+    GOERTZEL filt;
+    double v;
+    INT16U i;
+    INT8U h;
+    INT8U b;
+
+    for(h = 0; h < TEST_BINS; h++){
+        for(i = 0; i < TEST_N; i++){
+            testBuf[i] = (INT16S)lrint(10000.0*sin((2.0*TEST_PI*(h + 1)*TEST_BIN*i)/TEST_N + 0.5));
+        }
+        for(b = 0; b < TEST_BINS; b++){
+            if(b == h){
+                fails += testCheck("tone on bin", b, testRun(b, TEST_N), 10000, TEST_ON_TOL(10000));
+            } else{
+                fails += testCheck("tone off bin", b, testRun(b, TEST_N), 0, TEST_OFF_TOL);
+            }
+        }
+    }
+
+    for(i = 0; i < TEST_N; i++){
+        v = TEST_DC + testNoise();
+        for(h = 0; h < TEST_BINS; h++){
+            v += testMixAmp[h]*sin((2.0*TEST_PI*(h + 1)*TEST_BIN*i)/TEST_N + 0.3*h);
+        }
+        testBuf[i] = (INT16S)lrint(v);
+    }
+    for(b = 0; b < TEST_BINS; b++){
+        amp = testRun(b, TEST_N);
+        fails += testCheck("mix", b, amp, (INT32U)testMixAmp[b], TEST_MIX_TOL((INT32U)testMixAmp[b]));
+        fails += testCheck("mix split", b, testRun(b, 100), amp, 0);
+    }
+
+    for(i = 0; i < TEST_N; i++){
+        testBuf[i] = (INT16S)lrint(32767.0*sin((2.0*TEST_PI*TEST_BIN*i)/TEST_N));
+    }
+    GoertzelInit(&filt, testCoeff[0]);
+    for(i = 0; i < TEST_N; i++){
+        GoertzelRun(&filt, &testBuf[i], 1);
+        if(labs(filt.s1) > s1_max){
+            s1_max = labs(filt.s1);
+        } else{
+        }
+    }
+    fails += testCheck("full scale", 0, GoertzelAmplitude(&filt, TEST_N), 32767, TEST_ON_TOL(32767));
+    if(s1_max > TEST_STATE_MAX){
+        printf("goertzel_test: FAIL full scale, peak state %ld over 32 bits\n", (long)s1_max);
+        fails++;
+    } else{
+        printf("goertzel_test: full scale, peak state %ld\n", (long)s1_max);
+    }
+
+    return((fails == 0) ? 0 : 1);
+}
+/********************************************************************
+* testRun - Reads one bin of testBuf
+*
+* Return value: Amplitude
+*
+* Arguments:    Bin index, samples given per GoertzelRun() call
+********************************************************************/
+static INT32U testRun(INT8U bin, INT16U split){
+    GOERTZEL filt;
+    INT16U done;
+    INT16U num;
+
+    GoertzelInit(&filt, testCoeff[bin]);
+    for(done = 0; done < TEST_N; done += num){
+        num = (INT16U)(((TEST_N - done) < split) ? (TEST_N - done) : split);
+        GoertzelRun(&filt, &testBuf[done], num);
+    }
+    return(GoertzelAmplitude(&filt, TEST_N));
+}
+/********************************************************************
+* testCheck - Prints a result and whether it is within tolerance
+*
+* Return value: 1 if out of tolerance, else 0
+*
+* Arguments:    Check name, bin index, amplitude read and expected,
+*               largest difference allowed
+********************************************************************/
+static INT8U testCheck(const char *name, INT8U bin, INT32U got, INT32U expect, INT32U tol){
+    INT32U diff = (got > expect) ? (got - expect) : (expect - got);
+
+    if(diff > tol){
+        printf("goertzel_test: FAIL %s, harmonic %u: %lu, expected %lu +-%lu\n",
+               name, bin + 1, (unsigned long)got, (unsigned long)expect, (unsigned long)tol);
+        return(1);
+    } else{
+        printf("goertzel_test: %s, harmonic %u: %lu\n", name, bin + 1, (unsigned long)got);
+        return(0);
+    }
+}
+/********************************************************************
+* testNoise - Repeatable uniform noise, -TEST_NOISE..TEST_NOISE
+*
+* Return value: Noise sample
+*
+* Arguments:    None
+********************************************************************/
+static INT32S testNoise(void){
+    testSeed = (testSeed*1103515245uL) + 12345uL;
+    return((INT32S)((testSeed >> 16) % (2*TEST_NOISE + 1)) - TEST_NOISE);
+}
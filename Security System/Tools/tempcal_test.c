@@ -0,0 +1,104 @@
+/*******************************************************************************
+* tempcal_test.c - Host check of TempCal.c over every ADC code
+*
+* Description: Every 16 bit code, and every code with its TEMP_CAL_FRAC_BITS
+*              fraction as the decimator gives it, goes through
+*              TempCalCodeToCenti() and is compared with the MCP9701
+*              transfer function, Vout = 400mV + 19.5mV/C, clamped to
+*              -10.00..125.00 C. Also checks that the conversion never
+*              decreases and that TempCalCentiToCode() of each whole
+*              0.01 C converts back within 0.01 C plus half a code step.
+*              Prints the worst error and fails if it is over 0.01 C.
+*
+*              Build: gcc -I../Sources -I../CMSIS -o tempcal_test
+*                         tempcal_test.c ../Sources/TempCal.c -lm
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#include <stdio.h>
+#include <math.h>
+#include "MCUType.h"
+#include "TempCal.h"
+
+#define TEST_MAX_ERR 1.0                //Largest error allowed, 0.01C
+#define TEST_CENTI_MIN -1000
+#define TEST_CENTI_MAX 12500
+#define TEST_CODES (1uL << (16 + TEMP_CAL_FRAC_BITS))
+
+static double testExpect(INT32U code);
+
+int main(void){
+    INT32U code;
+    INT32U worst_code = 0;
+    INT32S centi;
+    INT32S prev = TEST_CENTI_MIN;
+    INT32S back;
+    INT32S worst_back = 0;
+    double err;
+    double worst = 0.0;
+    double step;
+    int fails = 0;
+
+    for(code = 0; code < TEST_CODES; code++){
+        centi = TempCalCodeToCenti(code);
+        err = fabs(centi - testExpect(code));
+        if(err > worst){
+            worst = err;
+            worst_code = code;
+        } else{
+        }
+        if(centi < prev){
+            printf("tempcal_test: code 0x%05lx gives %ld, under %ld\n",
+                   (unsigned long)code, (long)centi, (long)prev);
+            fails++;
+        } else{
+        }
+        prev = centi;
+    }
+    /* One 16 bit code step in 0.01C, the inverse rounds to whole codes */
+    step = 100.0*TEMP_VREF_UV10/65536.0/195.0;
+    for(centi = TEST_CENTI_MIN; centi <= TEST_CENTI_MAX; centi++){
+        back = TempCalCodeToCenti((INT32U)TempCalCentiToCode(centi) << TEMP_CAL_FRAC_BITS) - centi;
+        if(back < 0){
+            back = -back;
+        } else{
+        }
+        if(back > worst_back){
+            worst_back = back;
+        } else{
+        }
+    }
+    printf("tempcal_test: worst %.3f C at code 0x%05lx, round trip %ld.%02ld C\n",
+           worst/100.0, (unsigned long)worst_code, (long)(worst_back/100), (long)(worst_back%100));
+    if(worst > TEST_MAX_ERR){
+        printf("tempcal_test: FAIL, over %.2f C\n", TEST_MAX_ERR/100.0);
+        fails++;
+    } else{
+    }
+    if(worst_back > (TEST_MAX_ERR + step/2.0)){
+        printf("tempcal_test: FAIL, round trip over half a code step\n");
+        fails++;
+    } else{
+    }
+    return((fails == 0) ? 0 : 1);
+}
+/********************************************************************
+* testExpect - MCP9701 temperature of a code, clamped as the table is
+*
+* Return value: Temperature in 0.01 C
+*
+* Arguments:    ADC code with TEMP_CAL_FRAC_BITS fraction
+********************************************************************/
+static double testExpect(INT32U code){
+    double uv10 = (double)code*TEMP_VREF_UV10/(double)TEST_CODES;
+    double centi = (uv10 - 4000.0)*100.0/195.0;
+
+    if(centi < TEST_CENTI_MIN){
+        centi = TEST_CENTI_MIN;
+    } else if(centi > TEST_CENTI_MAX){
+        centi = TEST_CENTI_MAX;
+    } else{
+    }
+    return(centi);
+}
@@ -0,0 +1,191 @@
+/*******************************************************************************
+* tsi_replay.c - Host replay of TSICNT traces through the touch decision and
+*                the gesture classifier
+*
+* Description: Each trace file is text, one scan a line:
+*                  cal electrode count     startup calibration scans
+*                  time_ms electrode count scans as LPTMR0 triggers them
+*              and '#' comment lines, one of which is "# expect" followed
+*              by the gestures the trace should give, or NONE.
+*              The calibration scans go through TSITouchStats() and
+*              TSITouchInit() as in TSIInit(). A scan then reaches
+*              TSITouchSample() the way it reaches tsiTrack() in
+*              TSI0_IRQHandler: the first scan after a change of electrode,
+*              and any scan outside the threshold window set from
+*              TSITouchLevel()/TSITouchReleaseLevel(). A change of the
+*              touched bitmask is fed to TSIGestureFeed() at the scan's
+*              time. Each file must end with no pad touched.
+*              Prints one line per file and fails if any gives gestures
+*              other than expected.
+*
+*              Build: gcc -DTSI_FILT_SIMD_EN=0 -I../Sources -I../Board
+*                         -I../CMSIS -o tsi_replay tsi_replay.c
+*                         ../Board/TSITouch.c ../Board/TSIFilter.c
+*                         ../Board/TSIGesture.c
+*              Use:   tsi_replay tsi_traces/<name>.txt ...
+*
+* Created on: Oct 19, 2026
+* Author: Anthony Needles
+*******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "MCUType.h"
+#include "TSI.h"
+#include "TSITouch.h"
+#include "TSIGesture.h"
+
+#define REPLAY_LINE 128
+#define REPLAY_CAL_MAX 64           //Calibration scans per electrode
+#define REPLAY_FLUSH_MS 1000        //Past the last scan, closes all windows
+
+/* Electrode limits as in tsiElectrodes[] of TSI.c */
+static const TSI_TOUCH_LIMITS replayLimits[TSI_NUM_ELECTRODES] = {
+    {8, 4, 32},
+    {8, 4, 32}
+};
+static const char *replayNames[] = {
+    "NONE", "TAP", "HOLD", "SLIDE_FWD", "SLIDE_BACK"
+};
+
+static INT32U replayNow;
+
+static INT8U replayFile(const char *path);
+static void replayGesture(char *got);
+
+int main(int argc, char **argv){
+    int fails = 0;
+    int i;
+
+    if(argc < 2){
+        fprintf(stderr, "usage: tsi_replay trace.txt ...\n");
+        return(2);
+    } else{
+    }
+    for(i = 1; i < argc; i++){
+        if(replayFile(argv[i]) == 0){
+            fails++;
+        } else{
+        }
+    }
+    return((fails == 0) ? 0 : 1);
+}
+
+/********************************************************************
+* replayFile - Replays one trace and checks its gestures
+*
+* Return value: 1 if the gestures match the expected ones, else 0
+*
+* Arguments:    Trace file path
+********************************************************************/
+static INT8U replayFile(const char *path){
+    FILE *f = fopen(path, "r");
+    char line[REPLAY_LINE];
+    char expect[REPLAY_LINE] = "";
+    char got[REPLAY_LINE] = "";
+    INT16U cal[TSI_NUM_ELECTRODES][REPLAY_CAL_MAX];
+    INT8U ncal[TSI_NUM_ELECTRODES] = {0};
+    INT8U started = 0;
+    INT8U last = 0xFFu;
+    INT8U feed;
+    INT32U base_q8;
+    INT32U noise_q8;
+    unsigned long t;
+    unsigned int e;
+    unsigned int count;
+    INT8U i;
+
+    if(f == 0){
+        printf("%s: can not open\n", path);
+        return(0);
+    } else{
+    }
+    while(fgets(line, sizeof(line), f) != 0){
+        if(strncmp(line, "# expect ", 9) == 0){
+            strcpy(expect, &line[9]);
+            expect[strcspn(expect, "\r\n")] = '\0';
+        } else if(line[0] == '#'){
+        } else if(sscanf(line, "cal %u %u", &e, &count) == 2){
+            if((e < TSI_NUM_ELECTRODES) && (ncal[e] < REPLAY_CAL_MAX)){
+                cal[e][ncal[e]++] = (INT16U)count;
+            } else{
+            }
+        } else if(sscanf(line, "%lu %u %u", &t, &e, &count) == 3){
+            if(started == 0){
+                for(i = 0; i < TSI_NUM_ELECTRODES; i++){
+                    TSITouchStats(cal[i], ncal[i], &base_q8, &noise_q8);
+                    TSITouchInit(i, &replayLimits[i], base_q8, noise_q8);
+                }
+                started = 1;
+            } else{
+            }
+            replayNow = (INT32U)t;
+            if(e != last){
+                feed = 1;
+            } else if((TSITouchMask() & (1uL << e)) == 0){
+                feed = (INT8U)(count > TSITouchLevel((INT8U)e));
+            } else{
+                feed = (INT8U)(count < TSITouchReleaseLevel((INT8U)e));
+            }
+            last = (INT8U)e;
+            if((feed != 0) && (TSITouchSample((INT8U)e, (INT16U)count) != 0)){
+                TSIGestureFeed(TSITouchMask(), replayNow);
+            } else{
+            }
+            TSIGestureTimeout(replayNow);
+            replayGesture(got);
+        } else{
+        }
+    }
+    fclose(f);
+    replayNow += REPLAY_FLUSH_MS;
+    TSIGestureTimeout(replayNow);
+    replayGesture(got);
+    if(got[0] == '\0'){
+        strcpy(got, "NONE");
+    } else{
+    }
+
+    if(TSITouchMask() != 0){
+        printf("%s: FAIL, ends with pads touched\n", path);
+        return(0);
+    } else if(strcmp(got, expect) != 0){
+        printf("%s: FAIL, got %s, expected %s\n", path, got, expect);
+        return(0);
+    } else{
+        printf("%s: %s\n", path, got);
+        return(1);
+    }
+}
+/********************************************************************
+* replayGesture - Appends a gesture, if there is one, to the list
+*
+* Return value: None
+*
+* Arguments:    Space separated list of gesture names
+********************************************************************/
+static void replayGesture(char *got){
+    TSI_GESTURE gesture = TSIGestureGet();
+
+    if((gesture != TSI_GEST_NONE) && (strlen(got) < (REPLAY_LINE - 12))){
+        if(got[0] != '\0'){
+            strcat(got, " ");
+        } else{
+        }
+        strcat(got, replayNames[gesture]);
+    } else{
+    }
+}
+/********************************************************************
+* TSIGetEvent/SysTickGetmsCount - Stand-ins for the firmware
+*
+* Description:  Only TSIGestureTask() calls these, and the replay feeds
+*               the classifier directly, so there are never queued events
+*               and the time is that of the scan being replayed.
+********************************************************************/
+INT8U TSIGetEvent(TSI_EVENT *event){
+    (void)event;
+    return(0);
+}
+INT32U SysTickGetmsCount(void){
+    return(replayNow);
+}